@@ -0,0 +1,605 @@
+// Arithmetic.h
+// Politiques arithmétiques du moteur PrimeEngine : une par largeur de mot.
+// Chaque politique fournit
+//   using value_type;                          type des candidats
+//   bool probable_prime(const value_type& n);  test de primalité de n impair,
+//                                              sans facteur dans SMALL_PRIMES
+//   Policy fork(unsigned salt) const;          copie pour un autre thread (générateur
+//                                              aléatoire propre)
+//
+//  - Arith32 / Arith64 : Miller-Rabin déterministe (3 bases, produits 64 bits /
+//    7 bases, produits 128 bits)
+//  - MillerRabinArith<T, W> : largeurs > 64 bits, W contient le produit de deux T
+//    (Arith128, FixedArith<Bits>, BigArith = cpp_int) ; pour cpp_int, powmod passe
+//    par la multiplication NTT (Ntt.h) au-delà de ntt_threshold_bits() ; un module
+//    proche de 2^k est réduit par décalages (SpecialForm)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Détection MSVC pour utiliser _umul128
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/multiprecision/integer.hpp>
+
+#include "Ntt.h"
+#include "SmallPrimes.h"
+
+namespace primes {
+
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+#ifndef _MSC_VER
+using u128 = unsigned __int128; // utilisé uniquement sur GCC/Clang
+#endif
+
+using boost::multiprecision::cpp_int;
+using boost::multiprecision::uint128_t;
+using boost::multiprecision::uint256_t;
+
+// Entier non signé de Bits bits, à taille fixe (pas d'allocation).
+template <unsigned Bits>
+using fixed_uint = boost::multiprecision::number<boost::multiprecision::cpp_int_backend<
+    Bits, Bits, boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>>;
+
+// Multiplie a * b mod m sans overflow pour 64 bits.
+// Implémentation portable : utilise _umul128 sur MSVC, __uint128_t sinon.
+inline u64 mul_mod(u64 a, u64 b, u64 mod) {
+#ifdef _MSC_VER
+  // MSVC : _umul128 retourne la partie basse et la partie haute dans *high
+  unsigned long long high;
+  unsigned long long low = _umul128(a, b, &high);
+  // on a 128-bit = (high << 64) | low. On doit faire (a*b) % mod.
+  // Réduction par division 128/64 (utilise builtin 128 via pair high/low).
+  // On convertit en builtin 128 pour simplifier la division si possible:
+  // MSVC ne supporte __uint128_t ; simulons la division en utilisant
+  // l'algorithme de réduction double-and-add — mais pour simplicité et
+  // performance, utilisons long double trick si mod fits in 64 bits.
+  // Simpler approach: use builtin algorithm: (a*b - q*mod) where q = (unsigned __int128)(a*b)/mod
+  // But MSVC lacks unsigned __int128. So we'll implement 128-bit division manually:
+  // Use std::uint64_t high, low and perform manual division (Knuth) — but that's long.
+  // Simpler and sufficiently fast: use loop doubling (binary method).
+  u64 result = 0;
+  u64 base = a % mod;
+  u64 bb = b;
+  while (bb) {
+    if (bb & 1) {
+      // result = (result + base) % mod, avoid overflow by subtraction
+      u64 tmp = result + base;
+      if (tmp < result || tmp >= mod) tmp = (tmp % mod);
+      result = tmp % mod;
+    }
+
+    bb >>= 1;
+    if (bb) {
+      // base = (base * 2) % mod, safe
+      base = base + base;
+      if (base >= mod || base < base - base) base %= mod;
+    }
+  }
+
+  return result % mod;
+#else
+  // GCC/Clang : on a __uint128_t
+  u128 res = (u128)a * (u128)b;
+  res %= mod;
+  return (u64)res;
+#endif
+}
+
+// Exponentiation modulaire
+inline u64 pow_mod(u64 a, u64 d, u64 mod) {
+  u64 res = 1;
+  a %= mod;
+  while (d) {
+    if (d & 1) res = mul_mod(res, a, mod);
+    a = mul_mod(a, a, mod);
+    d >>= 1;
+  }
+
+  return res;
+}
+
+// Partie haute du produit 64 x 64 -> 128 bits.
+inline u64 mul_hi(u64 a, u64 b) {
+#ifdef _MSC_VER
+  return __umulh(a, b);
+#else
+  return static_cast<u64>((static_cast<u128>(a) * b) >> 64);
+#endif
+}
+
+// Arithmétique de Montgomery modulo n impair (R = 2^64) : mul(a, b) = a * b / R mod n
+// avec deux multiplications et une partie haute, sans division 128/64 (ni sur MSVC
+// la boucle double-and-add de mul_mod).
+struct Montgomery64 {
+  u64 n, inv, r2, one, minus_one;
+
+  explicit Montgomery64(u64 mod) : n(mod), inv(detail::inverse_mod_2_64(mod)) {
+    one = (0 - n) % n; // R mod n
+#ifdef _MSC_VER
+    r2 = one;          // R^2 mod n par 64 doublements
+    for (int i = 0; i < 64; ++i) r2 = add(r2, r2);
+#else
+    r2 = static_cast<u64>((static_cast<u128>(one) << 64) % n);
+#endif
+    minus_one = n - one;
+  }
+
+  u64 add(u64 a, u64 b) const { return a >= n - b ? a - (n - b) : a + b; }
+  u64 sub(u64 a, u64 b) const { return a >= b ? a - b : a + (n - b); }
+
+  // (hi * 2^64 + lo) / R mod n, pour hi < n
+  u64 reduce(u64 hi, u64 lo) const {
+    const u64 m = lo * inv;
+    const u64 mh = mul_hi(m, n);
+    return hi >= mh ? hi - mh : hi - mh + n;
+  }
+
+  u64 mul(u64 a, u64 b) const { return reduce(mul_hi(a, b), a * b); }
+  u64 to_mont(u64 x) const { return mul(x % n, r2); }
+  u64 from_mont(u64 x) const { return reduce(0, x); }
+
+  u64 pow(u64 base, u64 e) const {
+    u64 res = one;
+    while (e) {
+      if (e & 1) res = mul(res, base);
+      base = mul(base, base);
+      e >>= 1;
+    }
+    return res;
+  }
+};
+
+// Quatre exponentiations de Montgomery indépendantes, entrelacées : une seule chaîne
+// laisse le multiplieur attendre son résultat précédent, quatre chaînes le remplissent.
+// Une voie d'exposant nul ne fait que des carrés inutiles et renvoie 1 (forme Montgomery).
+inline void pow_mont4(const Montgomery64* m, const u64* base, const u64* exp, u64* out) {
+  u64 b0 = base[0], b1 = base[1], b2 = base[2], b3 = base[3];
+  u64 e0 = exp[0], e1 = exp[1], e2 = exp[2], e3 = exp[3];
+  u64 r0 = m[0].one, r1 = m[1].one, r2 = m[2].one, r3 = m[3].one;
+  while ((e0 | e1 | e2 | e3) != 0) {
+    if (e0 & 1) r0 = m[0].mul(r0, b0);
+    if (e1 & 1) r1 = m[1].mul(r1, b1);
+    if (e2 & 1) r2 = m[2].mul(r2, b2);
+    if (e3 & 1) r3 = m[3].mul(r3, b3);
+    b0 = m[0].mul(b0, b0);
+    b1 = m[1].mul(b1, b1);
+    b2 = m[2].mul(b2, b2);
+    b3 = m[3].mul(b3, b3);
+    e0 >>= 1; e1 >>= 1; e2 >>= 1; e3 >>= 1;
+  }
+  out[0] = r0; out[1] = r1; out[2] = r2; out[3] = r3;
+}
+
+// Module de forme spéciale m = 2^k + c ou 2^k - c avec c < 2^(k/2) (pseudo-Mersenne,
+// comme les candidats juste au-dessus ou au-dessous d'une puissance de deux) :
+// x = h·2^k + l = l -/+ h·c (mod m), soit un décalage, un masque et un petit produit
+// au lieu d'une division. W contient le produit de deux résidus.
+template <class W>
+class SpecialForm {
+public:
+  explicit SpecialForm(const W& m) : m_(m) {
+    if (m < 3) return;
+    const unsigned top = static_cast<unsigned>(boost::multiprecision::msb(m));
+    const W low = m - (W(1) << top);
+    if (low != 0 && 2 * (static_cast<unsigned>(boost::multiprecision::msb(low)) + 1) <= top) {
+      k_ = top;
+      c_ = low;
+      plus_ = true;
+    }
+    else if (top + 1 < std::numeric_limits<W>::digits || !std::numeric_limits<W>::is_bounded) {
+      const W high = (W(1) << (top + 1)) - m;
+      if (2 * (static_cast<unsigned>(boost::multiprecision::msb(high)) + 1) <= top + 1) {
+        k_ = top + 1;
+        c_ = high;
+      }
+    }
+    if (k_ != 0) mask_ = (W(1) << k_) - 1;
+  }
+
+  explicit operator bool() const { return k_ != 0; }
+
+  // x mod m, pour x < m^2 : chaque passage retire au moins k/2 bits
+  W reduce(W x) const {
+    if (plus_) {
+      if (x < m_) return x;
+      const W t = reduce((x >> k_) * c_);
+      const W l = x & mask_;
+      return l >= t ? W(l - t) : W(l + m_ - t);
+    }
+    while (x > mask_) x = (x >> k_) * c_ + (x & mask_);
+    return x >= m_ ? W(x - m_) : x;
+  }
+
+private:
+  W m_, c_ = 0, mask_ = 0;
+  unsigned k_ = 0;
+  bool plus_ = false;
+};
+
+// SpecialForm ne bat la division de Boost qu'à partir de produits de plus de 256 bits
+// (uint256_t divise vite par un module de deux mots).
+template <class W>
+constexpr bool special_form_pays() {
+  return !std::numeric_limits<W>::is_bounded || std::numeric_limits<W>::digits > 256;
+}
+
+// Exponentiation binaire, reduce(x) = x mod m pour x < m^2.
+// Si cancel passe à vrai, s'interrompt (résultat alors sans signification).
+template <class T, class W, class Reduce>
+inline T powmod_with(T base, T exp, const T& mod, Reduce&& reduce, const std::atomic<bool>* cancel = nullptr) {
+  T res = 1 % mod;
+  base %= mod;
+  while (exp != 0) {
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) break;
+    if ((exp & 1) != 0) res = static_cast<T>(reduce(W(res) * W(base)));
+    base = static_cast<T>(reduce(W(base) * W(base)));
+    exp >>= 1;
+  }
+  return res;
+}
+
+// Exponentiation modulaire générique : W contient le produit de deux T. Pour les
+// produits de plus de 256 bits, un module de forme 2^k +/- c est réduit par SpecialForm.
+// Si cancel passe à vrai, s'interrompt (résultat alors sans signification).
+template <class T, class W = T>
+inline T powmod(T base, T exp, const T& mod, const std::atomic<bool>* cancel = nullptr) {
+  if constexpr (std::is_same<T, cpp_int>::value) {
+    if (use_ntt_powmod(mod)) return powmod_ntt(base, exp, NttModulus(mod), cancel);
+  }
+  if constexpr (special_form_pays<W>()) {
+    const SpecialForm<W> form{W(mod)};
+    if (form) return powmod_with<T, W>(base, exp, mod, [&form](const W& x) { return form.reduce(x); }, cancel);
+  }
+  const W m = mod;
+  return powmod_with<T, W>(base, exp, mod, [&m](const W& x) { return W(x % m); }, cancel);
+}
+
+// Fin d'un tour de Miller-Rabin pour n - 1 = d * 2^s, x = a^d mod n :
+// vrai si a n'est pas un témoin de composition. sqr(x) = x * x mod n.
+template <class T, class Sqr>
+inline bool strong_probable_prime(const T& n, unsigned s, T x, Sqr&& sqr) {
+  const T n_minus_1 = n - 1;
+  if (x == 1 || x == n_minus_1) return true;
+  for (unsigned r = 1; r < s; ++r) {
+    x = sqr(x);
+    if (x == n_minus_1) return true;
+  }
+  return false;
+}
+
+// Chemin rapide 32 bits : produits sur 64 bits natifs (pas de division 128/64) et
+// seulement 3 bases {2, 7, 61}, déterministes pour n < 4 759 123 141 (> 2^32).
+struct Arith32 {
+  using value_type = u32;
+
+  Arith32 fork(unsigned) const { return *this; }
+
+  bool probable_prime(u32 n) {
+    u32 d = n - 1;
+    unsigned s = 0;
+    while ((d & 1) == 0) { d >>= 1; ++s; }
+
+    const u32 bases[] = { 2u, 7u, 61u };
+    auto sqr = [n](u32 x) { return static_cast<u32>(u64(x) * x % n); };
+    for (u32 a : bases) {
+      if (a % n == 0) continue;
+      if (!strong_probable_prime(n, s, powmod<u32, u64>(a, d, n), sqr)) return false;
+    }
+    return true;
+  }
+};
+
+// Symbole de Jacobi (a / n), n impair.
+inline int jacobi(u64 a, u64 n) {
+  int t = 1;
+  a %= n;
+  while (a != 0) {
+    while ((a & 1) == 0) {
+      a >>= 1;
+      const u64 r = n & 7;
+      if (r == 3 || r == 5) t = -t;
+    }
+    std::swap(a, n);
+    if ((a & 3) == 3 && (n & 3) == 3) t = -t;
+    a %= n;
+  }
+  return n == 1 ? t : 0;
+}
+
+inline bool is_square(u64 n) {
+  u64 r = static_cast<u64>(std::sqrt(static_cast<double>(n)));
+  if (r > 0xFFFFFFFFull) r = 0xFFFFFFFFull;
+  while (r * r > n) --r;
+  while (r < 0xFFFFFFFFull && (r + 1) * (r + 1) <= n) ++r;
+  return r * r == n;
+}
+
+// Test de Lucas fort (paramètres de Selfridge, méthode A : P = 1, Q = (1 - D) / 4
+// avec D premier terme de 5, -7, 9, -11, ... tel que (D / n) = -1). n impair, non carré.
+inline bool strong_lucas_prime(u64 n) {
+  long long D = 5;
+  while (true) {
+    const u64 dm = D > 0 ? u64(D) % n : n - u64(-D) % n;
+    const int j = jacobi(dm, n);
+    if (j == -1) break;
+    if (j == 0 && u64(D > 0 ? D : -D) != n) return false;
+    D = D > 0 ? -(D + 2) : -D + 2;
+  }
+  const long long q = (1 - D) / 4;
+  const Montgomery64 m(n);
+  // toutes les valeurs en forme de Montgomery ; la division par 2 y est linéaire
+  const u64 dm = m.to_mont(D > 0 ? u64(D) % n : n - u64(-D) % n);
+  const u64 qm = m.to_mont(q >= 0 ? u64(q) % n : n - u64(-q) % n);
+  auto half = [n](u64 a) { return (a & 1) ? (a >> 1) + (n >> 1) + 1 : a >> 1; };
+
+  // n + 1 = d * 2^s (n < 2^64 - 1 : 2^64 - 1 est multiple de 3)
+  u64 d = n + 1;
+  unsigned s = 0;
+  while ((d & 1) == 0) { d >>= 1; ++s; }
+
+  // U_1 = 1, V_1 = P = 1, Qk = Q ; parcours des bits de d après le bit de poids fort
+  u64 u = m.one, v = m.one, qk = qm;
+  int bit = 63;
+  while (((d >> bit) & 1) == 0) --bit;
+  for (--bit; bit >= 0; --bit) {
+    u = m.mul(u, v);
+    v = m.sub(m.mul(v, v), m.add(qk, qk));
+    qk = m.mul(qk, qk);
+    if ((d >> bit) & 1) {
+      const u64 u2 = half(m.add(u, v));
+      v = half(m.add(m.mul(dm, u), v));
+      u = u2;
+      qk = m.mul(qk, qm);
+    }
+  }
+  if (u == 0 || v == 0) return true;
+  for (unsigned r = 1; r < s; ++r) {
+    v = m.sub(m.mul(v, v), m.add(qk, qk));
+    if (v == 0) return true;
+    qk = m.mul(qk, qk);
+  }
+  return false;
+}
+
+// Mode du test 64 bits :
+//  - Bases7 : 7 bases de Miller-Rabin (Sinclair), 7 exponentiations pour un premier ;
+//  - Bpsw   : 1 test fort en base 2 puis 1 test de Lucas fort, soit environ 3
+//             exponentiations ; sans pseudopremier connu sous 2^64 (liste de Feitsma).
+enum class Mr64Mode { Bases7, Bpsw };
+
+// Miller-Rabin déterministe pour 64-bit (bases spéciales), en arithmétique de Montgomery.
+// probable_prime_batch entrelace `lanes` exponentiations indépendantes ;
+// PrimeEngine l'utilise automatiquement quand une politique le fournit.
+struct Arith64 {
+  using value_type = u64;
+  static constexpr unsigned lanes = 4;
+
+  explicit Arith64(Mr64Mode mode = Mr64Mode::Bases7) : mode_(mode) {}
+
+  Arith64 fork(unsigned) const { return *this; }
+
+  bool probable_prime(u64 n) {
+    if (n <= std::numeric_limits<u32>::max()) return Arith32().probable_prime(static_cast<u32>(n));
+
+    // écrire n-1 = d * 2^s
+    u64 d = n - 1;
+    unsigned s = 0;
+    while ((d & 1) == 0) { d >>= 1; ++s; }
+    const Montgomery64 m(n);
+
+    if (mode_ == Mr64Mode::Bpsw) {
+      if (!strong_round(m, s, m.pow(m.to_mont(2), d))) return false;
+      return !is_square(n) && strong_lucas_prime(n);
+    }
+
+    for (u64 a : BASES) {
+      if (a % n == 0) continue;
+      if (!strong_round(m, s, m.pow(m.to_mont(a), d))) return false;
+    }
+    return true;
+  }
+
+  // out[i] = probable_prime(n[i]) pour i < count (n[i] > 2^32). Le tour en base 2
+  // tourne sur tous les candidats par groupes de `lanes`, puis les bases suivantes
+  // sur les seuls survivants, regroupés à nouveau : les voies restent pleines même
+  // quand la plupart des composés meurent au premier tour.
+  void probable_prime_batch(const u64* n, bool* out, size_t count) {
+    std::vector<Lane> lane;
+    lane.reserve(count);
+    std::vector<size_t> alive(count);
+    for (size_t i = 0; i < count; ++i) {
+      lane.emplace_back(n[i]);
+      alive[i] = i;
+      out[i] = true;
+    }
+
+    const size_t rounds = mode_ == Mr64Mode::Bpsw ? 1 : sizeof(BASES) / sizeof(BASES[0]);
+    for (size_t r = 0; r < rounds && !alive.empty(); ++r) {
+      size_t i = 0;
+      for (; i + lanes <= alive.size(); i += lanes) {
+        const Lane* l[lanes] = { &lane[alive[i]], &lane[alive[i + 1]], &lane[alive[i + 2]], &lane[alive[i + 3]] };
+        const Montgomery64 m[lanes] = { l[0]->m, l[1]->m, l[2]->m, l[3]->m };
+        const u64 base[lanes] = { m[0].to_mont(BASES[r]), m[1].to_mont(BASES[r]),
+                                  m[2].to_mont(BASES[r]), m[3].to_mont(BASES[r]) };
+        const u64 exp[lanes] = { l[0]->d, l[1]->d, l[2]->d, l[3]->d };
+        u64 x[lanes];
+        pow_mont4(m, base, exp, x);
+        for (unsigned k = 0; k < lanes; ++k) out[alive[i + k]] = strong_round(m[k], l[k]->s, x[k]);
+      }
+      for (; i < alive.size(); ++i) {
+        const Lane& l = lane[alive[i]];
+        out[alive[i]] = strong_round(l.m, l.s, l.m.pow(l.m.to_mont(BASES[r]), l.d));
+      }
+      alive.erase(std::remove_if(alive.begin(), alive.end(), [out](size_t k) { return !out[k]; }),
+                  alive.end());
+    }
+    if (mode_ == Mr64Mode::Bpsw) {
+      for (size_t k : alive) out[k] = !is_square(n[k]) && strong_lucas_prime(n[k]);
+    }
+  }
+
+private:
+  // bases déterministes pour n < 2^64 (la première, 2, sert aussi au mode Bpsw)
+  static constexpr u64 BASES[] = { 2ull, 325ull, 9375ull, 28178ull, 450775ull, 9780504ull, 1795265022ull };
+
+  // état d'un candidat de probable_prime_batch : n - 1 = d * 2^s
+  struct Lane {
+    Montgomery64 m;
+    u64 d;
+    unsigned s = 0;
+    explicit Lane(u64 n) : m(n), d(n - 1) {
+      while ((d & 1) == 0) { d >>= 1; ++s; }
+    }
+  };
+
+  // fin du tour de Miller-Rabin, x = a^d en forme de Montgomery
+  static bool strong_round(const Montgomery64& m, unsigned s, u64 x) {
+    if (x == m.one || x == m.minus_one) return true;
+    for (unsigned r = 1; r < s; ++r) {
+      x = m.mul(x, x);
+      if (x == m.minus_one) return true;
+    }
+    return false;
+  }
+
+  Mr64Mode mode_;
+};
+
+// Miller-Rabin pour les largeurs > 64 bits. En dessous de 3.3e24 (~2^81), les
+// 13 premiers nombres premiers comme bases rendent le test déterministe ;
+// au-delà, `rounds` bases aléatoires tirées du générateur de la politique.
+template <class T, class W = T>
+class MillerRabinArith {
+public:
+  using value_type = T;
+
+  explicit MillerRabinArith(int rounds = 32, u64 seed = std::random_device{}())
+    : rounds_(rounds), rng_(seed) {}
+
+  std::mt19937_64& rng() { return rng_; }
+
+  // Candidats d'au moins min_bits bits : leurs tours indépendants sont répartis sur
+  // `threads` threads, les tours restants étant abandonnés dès qu'un tour conclut
+  // à la composition (latence d'un seul candidat géant).
+  void set_round_threads(unsigned threads, unsigned min_bits) {
+    round_threads_ = std::max(1u, threads);
+    round_threads_min_bits_ = min_bits;
+  }
+
+  // Candidats traités par la NTT (cpp_int) : le premier tour devient un test fort en
+  // base 2 calculé par powmod_gerbicz, qui détecte et rattrape les erreurs de calcul.
+  void set_gerbicz(bool on) { gerbicz_ = on; }
+
+  MillerRabinArith fork(unsigned salt) const {
+    std::mt19937_64 copy = rng_;
+    MillerRabinArith f(rounds_, copy() ^ (u64(salt) * 0x9E3779B97F4A7C15ull));
+    f.set_round_threads(round_threads_, round_threads_min_bits_);
+    f.set_gerbicz(gerbicz_);
+    return f;
+  }
+
+  bool probable_prime(const T& n) {
+    const W mod = n;
+    auto sqr = [&mod](const T& x) { return static_cast<T>(W(x) * W(x) % mod); };
+
+    T d = n - 1;
+    unsigned s = 0;
+    while ((d & 1) == 0) { d >>= 1; ++s; }
+
+    static const cpp_int deterministic_limit("3317044064679887385961981");
+    if (cpp_int(n) < deterministic_limit) {
+      for (size_t i = 0; i < 13; ++i) {
+        if (!strong_probable_prime(n, s, powmod<T, W>(T(SMALL_PRIMES.prime[i]), d, n), sqr)) return false;
+      }
+      return true;
+    }
+    int done = 0;
+    if constexpr (std::is_same<T, cpp_int>::value) {
+      if (gerbicz_ && use_ntt_powmod(n)) {
+        if (!strong_probable_prime(n, s, powmod_gerbicz(cpp_int(2), d, NttModulus(n)), sqr)) return false;
+        done = 1;
+      }
+    }
+    if (round_threads_ > 1 && rounds_ - done > 1 && boost::multiprecision::msb(n) + 1 >= round_threads_min_bits_) {
+      // le premier tour écarte presque tous les composés : inutile de lancer des threads
+      if (done == 0 && !strong_probable_prime(n, s, powmod<T, W>(random_base(n), d, n), sqr)) return false;
+      return parallel_rounds(n, d, s, rounds_ - 1);
+    }
+    for (int t = done; t < rounds_; ++t) {
+      if (!strong_probable_prime(n, s, powmod<T, W>(random_base(n), d, n), sqr)) return false;
+    }
+    return true;
+  }
+
+private:
+  bool parallel_rounds(const T& n, const T& d, unsigned s, int rounds) {
+    // bases tirées d'avance : même suite qu'en séquentiel
+    std::vector<T> bases;
+    for (int t = 0; t < rounds; ++t) bases.push_back(random_base(n));
+
+    const W mod = n;
+    std::atomic<bool> composite(false);
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+      size_t i;
+      while (!composite.load() && (i = next++) < bases.size()) {
+        const T x = powmod<T, W>(bases[i], d, n, &composite);
+        if (composite.load()) return;
+        auto sqr = [&mod](const T& y) { return static_cast<T>(W(y) * W(y) % mod); };
+        if (!strong_probable_prime(n, s, x, sqr)) composite.store(true);
+      }
+    };
+    std::vector<std::thread> helpers;
+    for (unsigned t = 1; t < round_threads_; ++t) helpers.emplace_back(worker);
+    worker();
+    for (std::thread& t : helpers) t.join();
+    return !composite.load();
+  }
+
+  // base uniforme dans [2, n - 2]
+  T random_base(const T& n) {
+    std::uniform_int_distribution<u64> dist64(0, std::numeric_limits<u64>::max());
+    const cpp_int limit = cpp_int(n) - 3;
+    // calculer le nombre de "limbs" 64-bits nécessaires
+    unsigned long bits = boost::multiprecision::msb(limit) + 1;
+    size_t limbs = (bits + 63) / 64;
+    cpp_int a = 0;
+    for (size_t i = 0; i < limbs; ++i) {
+      a <<= 64;
+      a += dist64(rng_);
+    }
+    // ramener dans [2, n - 2]
+    a %= limit;
+    a += 2;
+    return static_cast<T>(a);
+  }
+
+  int rounds_;
+  std::mt19937_64 rng_;
+  unsigned round_threads_ = 1;
+  unsigned round_threads_min_bits_ = 16384;
+  bool gerbicz_ = false;
+};
+
+using Arith128 = MillerRabinArith<uint128_t, uint256_t>;
+template <unsigned Bits>
+using FixedArith = MillerRabinArith<fixed_uint<Bits>, fixed_uint<2 * Bits>>;
+using BigArith = MillerRabinArith<cpp_int>;
+
+} // namespace primes
@@ -0,0 +1,324 @@
+// AsyncOutput.h
+// Sortie confiée à un thread d'écriture. AsyncOutput est un std::streambuf dont la zone
+// d'écriture est un bloc de grande taille : le calcul y formate ses premiers sans appel
+// système, puis passe le bloc plein au thread d'écriture (write(2), _write sous Windows)
+// et continue dans un bloc libre. Avec `blocks` blocs en rotation, le calcul n'attend
+// que si tous sont en file ; ces attentes sont comptées (OutputStats).
+//
+// Politique de vidage (record_end, appelé après chaque premier) :
+//  - Full     : un bloc ne part que plein (débit maximal) ;
+//  - Line     : chaque enregistrement part aussitôt (suivi en direct d'un tube) ;
+//  - Interval : le bloc en cours part dès que rien n'a été écrit depuis interval_ms.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace primes {
+
+enum class FlushPolicy { Full, Line, Interval };
+
+struct OutputOptions {
+  std::size_t block_size = 1u << 20;
+  unsigned blocks = 4;
+  FlushPolicy flush = FlushPolicy::Full;
+  unsigned interval_ms = 100;
+  bool resume = false;            // reprise : le fichier est gardé jusqu'à resume_bytes, la suite
+  std::uint64_t resume_bytes = 0; // est écrite après (voir Checkpoint.h)
+};
+
+struct OutputStats {
+  std::uint64_t bytes = 0;        // octets écrits
+  std::uint64_t blocks = 0;       // blocs passés au thread d'écriture
+  std::uint64_t stalls = 0;       // fois où le calcul a attendu un bloc libre
+  double stall_seconds = 0;       // temps total de ces attentes
+  unsigned max_queued = 0;        // plus longue file de blocs en attente d'écriture
+};
+
+// --flush full|line|MS (MS : vidage après MS millisecondes sans écriture) ; faux si invalide.
+inline bool parse_flush(const std::string& text, OutputOptions& options) {
+  if (text == "full") options.flush = FlushPolicy::Full;
+  else if (text == "line") options.flush = FlushPolicy::Line;
+  else if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos) {
+    options.flush = FlushPolicy::Interval;
+    options.interval_ms = static_cast<unsigned>(std::stoul(text));
+  }
+  else return false;
+  return true;
+}
+
+// --output-stats : résumé d'une ligne, sur stderr par défaut.
+inline void print_output_stats(const OutputStats& stats, std::ostream& err = std::cerr) {
+  err << "sortie : " << stats.bytes << " octets en " << stats.blocks << " blocs, file max " << stats.max_queued
+      << ", calcul bloqué " << stats.stalls << " fois (" << stats.stall_seconds << " s)\n";
+}
+
+class AsyncOutput : public std::streambuf {
+public:
+  // path vide : sortie standard. Lève std::runtime_error si le fichier ne peut être créé.
+  explicit AsyncOutput(const std::string& path = std::string(), OutputOptions options = OutputOptions())
+    : options_(options) {
+    options_.blocks = std::max(2u, options_.blocks);
+    options_.block_size = std::max<std::size_t>(options_.block_size, 4096);
+    if (path.empty()) {
+      fd_ = 1;
+    }
+    else {
+#ifdef _WIN32
+      const int mode = _O_WRONLY | _O_CREAT | _O_BINARY | (options_.resume ? 0 : _O_TRUNC);
+      fd_ = ::_open(path.c_str(), mode, _S_IREAD | _S_IWRITE);
+#else
+      fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | (options_.resume ? 0 : O_TRUNC), 0644);
+#endif
+      if (fd_ < 0) throw std::runtime_error("création impossible : " + path);
+      owned_ = true;
+      if (options_.resume) resume_at(path);
+    }
+    blocks_.resize(options_.blocks);
+    for (std::vector<char>& b : blocks_) b.resize(options_.block_size);
+    for (unsigned i = 1; i < options_.blocks; ++i) free_.push_back(i);
+    take(0);
+    writer_ = std::thread([this] { writer_loop(); });
+  }
+
+  ~AsyncOutput() override { close(); }
+
+  AsyncOutput(const AsyncOutput&) = delete;
+  AsyncOutput& operator=(const AsyncOutput&) = delete;
+
+  // Fin d'un enregistrement : applique la politique de vidage.
+  void record_end() {
+    if (pptr() != pbase() && flush_due()) submit();
+  }
+
+  // Vrai si la politique demande d'envoyer maintenant ce qui est en tampon ; sert aussi
+  // aux tampons placés devant ce flux (OutputBuffer).
+  bool flush_due() const {
+    switch (options_.flush) {
+    case FlushPolicy::Line: return true;
+    case FlushPolicy::Interval: return due_.load(std::memory_order_relaxed);
+    default: return false;
+    }
+  }
+
+  // Envoie le bloc en cours, attend la fin des écritures et ferme le fichier.
+  // Renvoie faux si une écriture a échoué. Appelé aussi par le destructeur.
+  bool close() {
+    if (writer_.joinable()) {
+      if (pptr() != pbase()) submit();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+      }
+      work_.notify_one();
+      writer_.join();
+      if (owned_) {
+#ifdef _WIN32
+        ::_close(fd_);
+#else
+        ::close(fd_);
+#endif
+      }
+      setp(nullptr, nullptr);
+    }
+    return !failed_;
+  }
+
+  // Attend que tout ce qui a été formaté soit écrit et synchronisé sur disque (point de
+  // reprise) ; renvoie faux si une écriture a échoué.
+  bool drain() {
+    if (!writer_.joinable()) return !failed_;
+    if (pptr() != pbase()) submit();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      freed_.wait(lock, [this] { return free_.size() + 1 == blocks_.size(); });
+    }
+    if (owned_ && !failed_) {
+#ifdef _WIN32
+      if (::_commit(fd_) != 0) failed_ = true;
+#else
+      if (::fsync(fd_) != 0) failed_ = true;
+#endif
+    }
+    return !failed_;
+  }
+
+  // Position de la sortie : octets écrits, y compris ceux gardés à la reprise.
+  std::uint64_t position() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_.resume_bytes + stats_.bytes;
+  }
+
+  OutputStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    if (!writer_.joinable()) return traits_type::eof();
+    submit();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    if (!writer_.joinable()) return 0;
+    std::streamsize done = 0;
+    while (done < n) {
+      if (pptr() == epptr()) submit();
+      const std::streamsize len = std::min<std::streamsize>(n - done, epptr() - pptr());
+      std::memcpy(pptr(), s + done, static_cast<std::size_t>(len));
+      pbump(static_cast<int>(len));
+      done += len;
+    }
+    return n;
+  }
+
+  // std::ostream::flush : le bloc en cours part sans attendre d'être plein.
+  int sync() override {
+    if (writer_.joinable() && pptr() != pbase()) submit();
+    return failed_ ? -1 : 0;
+  }
+
+private:
+  void take(unsigned block) {
+    current_ = block;
+    char* begin = blocks_[block].data();
+    setp(begin, begin + blocks_[block].size());
+  }
+
+  // Passe le bloc en cours au thread d'écriture et en prend un libre (en attendant si besoin).
+  void submit() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queued_.emplace_back(current_, static_cast<std::size_t>(pptr() - pbase()));
+    ++stats_.blocks;
+    stats_.max_queued = std::max(stats_.max_queued, static_cast<unsigned>(queued_.size()));
+    work_.notify_one();
+    if (free_.empty()) {
+      const auto t0 = std::chrono::steady_clock::now();
+      ++stats_.stalls;
+      freed_.wait(lock, [this] { return !free_.empty(); });
+      stats_.stall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    const unsigned next = free_.front();
+    free_.pop_front();
+    lock.unlock();
+    take(next);
+    due_.store(false, std::memory_order_relaxed);
+  }
+
+  void writer_loop() {
+    const auto interval = std::chrono::milliseconds(std::max(1u, options_.interval_ms));
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      if (options_.flush == FlushPolicy::Interval) {
+        // sans bloc à écrire pendant un intervalle, demande l'envoi du bloc en cours
+        if (!work_.wait_for(lock, interval, [this] { return !queued_.empty() || closing_; })) {
+          due_.store(true, std::memory_order_relaxed);
+          continue;
+        }
+      }
+      else {
+        work_.wait(lock, [this] { return !queued_.empty() || closing_; });
+      }
+      if (queued_.empty()) return; // closing_ et tout est écrit
+      const std::pair<unsigned, std::size_t> item = queued_.front();
+      queued_.pop_front();
+      lock.unlock();
+      const bool ok = write_all(blocks_[item.first].data(), item.second);
+      lock.lock();
+      if (ok) stats_.bytes += item.second;
+      else failed_ = true;
+      free_.push_back(item.first);
+      freed_.notify_one();
+    }
+  }
+
+  // Coupe le fichier au point de reprise et se place à la fin.
+  void resume_at(const std::string& path) {
+#ifdef _WIN32
+    const bool ok = ::_filelengthi64(fd_) >= static_cast<__int64>(options_.resume_bytes) &&
+                    ::_chsize_s(fd_, static_cast<__int64>(options_.resume_bytes)) == 0 &&
+                    ::_lseeki64(fd_, 0, SEEK_END) >= 0;
+#else
+    struct stat st;
+    const bool ok = ::fstat(fd_, &st) == 0 && static_cast<std::uint64_t>(st.st_size) >= options_.resume_bytes &&
+                    ::ftruncate(fd_, static_cast<off_t>(options_.resume_bytes)) == 0 &&
+                    ::lseek(fd_, 0, SEEK_END) >= 0;
+#endif
+    if (!ok) {
+#ifdef _WIN32
+      ::_close(fd_);
+#else
+      ::close(fd_);
+#endif
+      throw std::runtime_error("reprise impossible (fichier plus court que le point de reprise) : " + path);
+    }
+  }
+
+  bool write_all(const char* data, std::size_t len) {
+    if (failed_) return false; // après une erreur, les blocs sont rendus sans être écrits
+    while (len > 0) {
+#ifdef _WIN32
+      const int chunk = static_cast<int>(std::min<std::size_t>(len, 1u << 30));
+      const int n = ::_write(fd_, data, static_cast<unsigned>(chunk));
+      if (n <= 0) return false;
+#else
+      const ssize_t n = ::write(fd_, data, len);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+#endif
+      data += n;
+      len -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  OutputOptions options_;
+  int fd_ = -1;
+  bool owned_ = false;
+  std::vector<std::vector<char>> blocks_;
+  unsigned current_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_, freed_;
+  std::deque<unsigned> free_;
+  std::deque<std::pair<unsigned, std::size_t>> queued_;
+  bool closing_ = false;
+  std::atomic<bool> failed_{ false };
+  std::atomic<bool> due_{ false };
+  OutputStats stats_;
+  std::thread writer_;
+};
+
+} // namespace primes
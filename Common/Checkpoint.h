@@ -0,0 +1,179 @@
+// Checkpoint.h
+// Point de reprise d'une génération longue (--checkpoint / --resume). Le fichier, texte
+// "clé valeur" par ligne, est réécrit toutes les N secondes ou N premiers :
+//
+//   primes-checkpoint 1
+//   start   <départ initial>         count  <premiers demandés>
+//   emitted <premiers déjà émis>     next   <candidat suivant le dernier émis>
+//   seed    <graine des bases de Miller-Rabin>
+//   format  <format de sortie>       output <fichier de sortie>  bytes <octets déjà écrits>
+//
+// Les entiers sont en hexadécimal (0x...), lus et écrits en temps quasi linéaire.
+// L'écriture est atomique : fichier temporaire synchronisé sur disque puis renommé ;
+// la sortie est vidée avant (AsyncOutput::drain), si bien qu'à la reprise elle est
+// coupée à `bytes` et complétée exactement là où le point de reprise l'avait laissée.
+// La reprise recommence le crible à `next` : les fenêtres sont décalées mais les
+// premiers émis sont les mêmes ; les bases aléatoires viennent de `seed`.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "Decimal.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace primes {
+
+using boost::multiprecision::cpp_int;
+
+struct CheckpointState {
+  cpp_int start;
+  std::uint64_t count = 0;
+  std::uint64_t emitted = 0;
+  cpp_int next;
+  std::uint64_t seed = 0;
+  std::string format;
+  std::string output;
+  std::uint64_t bytes = 0;
+};
+
+namespace checkpoint {
+
+inline std::string hex(const cpp_int& x) {
+  return "0x" + x.str(0, std::ios_base::hex);
+}
+
+// Écrit data dans path de façon atomique ; faux en cas d'échec (l'ancien fichier reste).
+inline bool write_atomic(const std::string& path, const std::string& data) {
+  const std::string tmp = path + ".tmp";
+#ifdef _WIN32
+  const int fd = ::_open(tmp.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+  if (fd < 0) return false;
+  bool ok = ::_write(fd, data.data(), static_cast<unsigned>(data.size())) == static_cast<int>(data.size());
+  ok = ::_commit(fd) == 0 && ok;
+  ok = ::_close(fd) == 0 && ok;
+  return ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  bool ok = ::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+  ok = ::fsync(fd) == 0 && ok;
+  ok = ::close(fd) == 0 && ok;
+  return ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+}
+
+} // namespace checkpoint
+
+inline bool save_checkpoint(const std::string& path, const CheckpointState& s) {
+  std::ostringstream out;
+  out << "primes-checkpoint 1\n"
+      << "start " << checkpoint::hex(s.start) << '\n'
+      << "count " << s.count << '\n'
+      << "emitted " << s.emitted << '\n'
+      << "next " << checkpoint::hex(s.next) << '\n'
+      << "seed " << s.seed << '\n'
+      << "format " << s.format << '\n'
+      << "output " << s.output << '\n'
+      << "bytes " << s.bytes << '\n';
+  return checkpoint::write_atomic(path, out.str());
+}
+
+// Lève std::runtime_error si le fichier est absent ou invalide.
+inline CheckpointState load_checkpoint(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::string key, value;
+  if (!(in >> key >> value) || key != "primes-checkpoint" || value != "1") {
+    throw std::runtime_error("point de reprise invalide : " + path);
+  }
+  CheckpointState s;
+  unsigned seen = 0;
+  while (in >> key) {
+    in.get();
+    std::getline(in, value);
+    if (key == "start") s.start = parse_integer(value.data(), value.size());
+    else if (key == "count") s.count = std::stoull(value);
+    else if (key == "emitted") s.emitted = std::stoull(value);
+    else if (key == "next") s.next = parse_integer(value.data(), value.size());
+    else if (key == "seed") s.seed = std::stoull(value);
+    else if (key == "format") s.format = value;
+    else if (key == "output") s.output = value;
+    else if (key == "bytes") s.bytes = std::stoull(value);
+    else continue;
+    ++seen;
+  }
+  if (seen != 8 || s.emitted > s.count) throw std::runtime_error("point de reprise incomplet : " + path);
+  return s;
+}
+
+// Suit les premiers émis et réécrit le point de reprise quand l'intervalle est écoulé.
+// record ne coûte qu'un incrément et une lecture d'horloge (~20 ns) : rien face au
+// test d'un premier. sync vide la sortie et renvoie sa position, ou faux en cas d'échec.
+class Checkpointer {
+public:
+  using Sync = std::function<bool(std::uint64_t& bytes)>;
+
+  Checkpointer(std::string path, CheckpointState state, unsigned seconds, std::uint64_t every, Sync sync)
+    : path_(std::move(path)), state_(std::move(state)), interval_(seconds), every_(every), sync_(std::move(sync)),
+      deadline_(std::chrono::steady_clock::now() + interval_), next_count_(every == 0 ? ~std::uint64_t(0) : state_.emitted + every) {}
+
+  template <class T>
+  void record(const T& p) {
+    ++state_.emitted;
+    if (state_.emitted >= next_count_ || (interval_.count() != 0 && std::chrono::steady_clock::now() >= deadline_)) {
+      save(cpp_int(p) + 1);
+    }
+  }
+
+  // Point de reprise final : emitted == count, une reprise n'a plus rien à faire.
+  bool finish() { return save(state_.next); }
+
+  bool save(const cpp_int& next) {
+    state_.next = next;
+    deadline_ = std::chrono::steady_clock::now() + interval_;
+    if (every_ != 0) next_count_ = state_.emitted + every_;
+    const bool ok = sync_(state_.bytes) && save_checkpoint(path_, state_);
+    if (!ok) ++failures_;
+    return ok;
+  }
+
+  const CheckpointState& state() const { return state_; }
+  unsigned failures() const { return failures_; }
+
+private:
+  std::string path_;
+  CheckpointState state_;
+  std::chrono::seconds interval_;
+  std::uint64_t every_;
+  Sync sync_;
+  std::chrono::steady_clock::time_point deadline_;
+  std::uint64_t next_count_;
+  unsigned failures_ = 0;
+};
+
+} // namespace primes
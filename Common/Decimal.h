@@ -0,0 +1,181 @@
+// Decimal.h
+// Conversions cpp_int <-> décimal en diviser pour régner, autour des puissances
+// 10^(L·2^i) gardées d'un appel à l'autre (DecimalPowers) :
+//  - DecimalWriter : x < 10^(2D) se coupe en x = q·10^D + r, q et r convertis
+//    récursivement (r complété par des zéros). Au-delà de ntt_threshold_bits(), la
+//    division se fait par Barrett avec l'inverse de la puissance (NttModulus, calculé
+//    une fois), ce qui rend la conversion quasi linéaire là où operator<< de Boost est
+//    quadratique. Les chiffres sont écrits dans un tampon réutilisé.
+//  - DecimalReader : le texte se coupe de même, x = haut·10^D + bas, recombinés par
+//    ntt::mul ; parse_hex lit l'hexadécimal sans multiplication.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "Ntt.h"
+
+namespace primes {
+
+// Puissances 10^digits(i), et leurs inverses de Barrett, créées à la demande.
+class DecimalPowers {
+public:
+  // Chiffres d'une feuille : 16 blocs de 19 chiffres (un mot de 64 bits chacun).
+  static constexpr std::size_t LEAF_DIGITS = 19 * 16;
+
+  static std::size_t digits(unsigned level) { return LEAF_DIGITS << level; }
+
+  const cpp_int& power(unsigned level) {
+    while (power_.size() <= level) {
+      power_.push_back(power_.empty() ? cpp_int(boost::multiprecision::pow(cpp_int(10), LEAF_DIGITS))
+                                      : ntt::mul(power_.back(), power_.back()));
+      barrett_.emplace_back();
+    }
+    return power_[level];
+  }
+
+  // x = q·10^digits(level) + r, pour x < 10^(2·digits(level))
+  void divide(const cpp_int& x, unsigned level, cpp_int& q, cpp_int& r) {
+    const cpp_int& p = power(level);
+    if (!use_ntt_powmod(p)) {
+      boost::multiprecision::divide_qr(x, p, q, r);
+      return;
+    }
+    if (!barrett_[level]) barrett_[level].reset(new NttModulus(p));
+    q = barrett_[level]->divide(x, r);
+  }
+
+private:
+  std::vector<cpp_int> power_;
+  std::vector<std::unique_ptr<NttModulus>> barrett_;
+};
+
+class DecimalWriter {
+public:
+  // Chiffres décimaux de x >= 0, valables jusqu'au prochain appel.
+  std::string_view format(const cpp_int& x) {
+    if (x == 0) return "0";
+    if (boost::multiprecision::msb(x) < DIRECT_BITS) {
+      const std::string text = x.str();
+      buffer_.assign(text.begin(), text.end());
+      return std::string_view(buffer_.data(), buffer_.size());
+    }
+    // nombre de chiffres <= floor(bits · log10(2)) + 1
+    const std::size_t bound = static_cast<std::size_t>((boost::multiprecision::msb(x) + 1) * 0.30103) + 1;
+    unsigned level = 0;
+    while (DecimalPowers::digits(level) < bound) ++level;
+    buffer_.resize(DecimalPowers::digits(level));
+    put(x, level, buffer_.data());
+    std::size_t first = 0;
+    while (buffer_[first] == '0') ++first;
+    return std::string_view(buffer_.data() + first, buffer_.size() - first);
+  }
+
+private:
+  // En dessous (une dizaine de milliers de chiffres), la conversion de Boost est plus rapide.
+  static constexpr unsigned DIRECT_BITS = 40000;
+  static constexpr std::uint64_t TEN19 = 10000000000000000000ull;
+
+  // Écrit exactement digits(level) chiffres de x < 10^digits(level).
+  void put(const cpp_int& x, unsigned level, char* out) {
+    if (level == 0) {
+      put_leaf(x, out);
+      return;
+    }
+    cpp_int q, r;
+    powers_.divide(x, level - 1, q, r);
+    put(q, level - 1, out);
+    put(r, level - 1, out + DecimalPowers::digits(level - 1));
+  }
+
+  static void put_leaf(cpp_int x, char* out) {
+    for (std::size_t end = DecimalPowers::LEAF_DIGITS; end > 0; end -= 19) {
+      std::uint64_t chunk = 0;
+      if (x != 0) {
+        cpp_int q, r;
+        boost::multiprecision::divide_qr(x, cpp_int(TEN19), q, r);
+        chunk = static_cast<std::uint64_t>(r);
+        x = std::move(q);
+      }
+      for (std::size_t i = end; i > end - 19; --i, chunk /= 10) out[i - 1] = static_cast<char>('0' + chunk % 10);
+    }
+  }
+
+  std::vector<char> buffer_;
+  DecimalPowers powers_;
+};
+
+// Lecture de grands entiers décimaux ; lève std::invalid_argument sur un caractère
+// qui n'est pas un chiffre.
+class DecimalReader {
+public:
+  cpp_int parse(const char* text, std::size_t len) {
+    if (len == 0) throw std::invalid_argument("entier vide");
+    return parse_range(text, len);
+  }
+
+private:
+  // En dessous, la lecture bloc par bloc (quadratique, comme Boost) reste la plus rapide.
+  static constexpr std::size_t DIRECT_DIGITS = DecimalPowers::LEAF_DIGITS * 16;
+
+  cpp_int parse_range(const char* text, std::size_t len) {
+    if (len <= DIRECT_DIGITS) return parse_leaf(text, len);
+    // plus grande puissance de moins de len chiffres : le haut n'est pas plus long que le bas
+    unsigned level = 0;
+    while (DecimalPowers::digits(level + 1) < len) ++level;
+    const std::size_t low = DecimalPowers::digits(level);
+    const cpp_int high = parse_range(text, len - low);
+    return ntt::mul(high, powers_.power(level)) + parse_range(text + len - low, low);
+  }
+
+  // par blocs de 19 chiffres (un mot), le premier bloc étant le plus court
+  static cpp_int parse_leaf(const char* text, std::size_t len) {
+    cpp_int x = 0;
+    std::size_t i = 0;
+    for (std::size_t block = (len - 1) % 19 + 1; i < len; block = 19) {
+      std::uint64_t chunk = 0, scale = 1;
+      for (std::size_t end = i + block; i < end; ++i) {
+        if (text[i] < '0' || text[i] > '9') throw std::invalid_argument("chiffre décimal attendu");
+        chunk = chunk * 10 + static_cast<std::uint64_t>(text[i] - '0');
+        scale *= 10;
+      }
+      x *= scale;
+      x += chunk;
+    }
+    return x;
+  }
+
+  DecimalPowers powers_;
+};
+
+// Entier hexadécimal (sans préfixe) : quatre bits par chiffre, aucune multiplication.
+inline cpp_int parse_hex(const char* text, std::size_t len) {
+  if (len == 0) throw std::invalid_argument("entier vide");
+  std::vector<unsigned char> nibbles(len);
+  for (std::size_t i = 0; i < len; ++i) {
+    const char c = text[i];
+    if (c >= '0' && c <= '9') nibbles[i] = static_cast<unsigned char>(c - '0');
+    else if (c >= 'a' && c <= 'f') nibbles[i] = static_cast<unsigned char>(c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') nibbles[i] = static_cast<unsigned char>(c - 'A' + 10);
+    else throw std::invalid_argument("chiffre hexadécimal attendu");
+  }
+  cpp_int x;
+  boost::multiprecision::import_bits(x, nibbles.begin(), nibbles.end(), 4, true);
+  return x;
+}
+
+// "0x..." en hexadécimal, sinon décimal.
+inline cpp_int parse_integer(const char* text, std::size_t len) {
+  if (len > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) return parse_hex(text + 2, len - 2);
+  return DecimalReader().parse(text, len);
+}
+
+} // namespace primes
@@ -0,0 +1,227 @@
+// GapFormat.h
+// Conteneur binaire compact pour une suite croissante de premiers (--format gaps) :
+//
+//   "PGAP" | version (1 octet) | premier de départ (entier)
+//   écarts : un varint LEB128 par premier suivant, écart / 2 (0 code l'écart 1 de 2 à 3)
+//   index  : par bloc de GAP_BLOCK premiers, position de l'écart qui suit son premier
+//            nombre (8 octets) puis valeur de ce premier nombre (entier)
+//   fin    : position de l'index (8 octets) | nombre de premiers (8 octets) | "PGIX"
+//
+// Entier : longueur en octets (varint) puis magnitude, octets de poids faible d'abord ;
+// les mots de 8 octets sont en petit-boutiste. L'index permet de relire à partir de
+// n'importe quel rang sans décoder ce qui précède : GapReader ne charge que l'index
+// et lit les écarts à partir du bloc voulu.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ios>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+namespace primes {
+
+using boost::multiprecision::cpp_int;
+
+// Premiers par bloc de l'index.
+constexpr std::size_t GAP_BLOCK = 4096;
+
+namespace gaps {
+
+inline void put_varint(std::vector<unsigned char>& out, std::uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<unsigned char>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<unsigned char>(v));
+}
+
+inline void put_u64(std::vector<unsigned char>& out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+inline void put_integer(std::vector<unsigned char>& out, const cpp_int& x) {
+  std::vector<unsigned char> bytes;
+  if (x != 0) boost::multiprecision::export_bits(x, std::back_inserter(bytes), 8, false);
+  put_varint(out, bytes.size());
+  out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+// Lecture séquentielle d'un flux par tampons de 64 Ko à partir de la position `pos`,
+// sans dépasser `end` ; lève std::runtime_error si le fichier est tronqué.
+class Cursor {
+public:
+  Cursor(std::istream& in, std::uint64_t pos, std::uint64_t end) : in_(in), pos_(pos), end_(end), buffer_(1u << 16) {}
+
+  unsigned char byte() {
+    if (next_ == filled_) refill();
+    return buffer_[next_++];
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+      const unsigned char b = byte();
+      v |= std::uint64_t(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) return v;
+    }
+  }
+
+  std::uint64_t u64() {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(byte()) << (8 * i);
+    return v;
+  }
+
+  cpp_int integer() {
+    const std::uint64_t len = varint();
+    if (len > end_ - pos_ + (filled_ - next_)) throw std::runtime_error("fichier de premiers tronqué");
+    std::vector<unsigned char> bytes(static_cast<std::size_t>(len));
+    for (unsigned char& b : bytes) b = byte();
+    cpp_int x = 0;
+    if (len != 0) boost::multiprecision::import_bits(x, bytes.begin(), bytes.end(), 8, false);
+    return x;
+  }
+
+private:
+  void refill() {
+    if (pos_ >= end_) throw std::runtime_error("fichier de premiers tronqué");
+    const std::size_t len = static_cast<std::size_t>(std::min<std::uint64_t>(buffer_.size(), end_ - pos_));
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(pos_));
+    in_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(len));
+    if (static_cast<std::size_t>(in_.gcount()) != len) throw std::runtime_error("fichier de premiers tronqué");
+    pos_ += len;
+    next_ = 0;
+    filled_ = len;
+  }
+
+  std::istream& in_;
+  std::uint64_t pos_, end_;
+  std::vector<unsigned char> buffer_;
+  std::size_t next_ = 0, filled_ = 0;
+};
+
+} // namespace gaps
+
+// Écrit le conteneur au fil des premiers (dans l'ordre croissant) ; finish() ajoute
+// l'index. Les écarts sont accumulés puis écrits par paquets de 64 Ko.
+class GapWriter {
+public:
+  explicit GapWriter(std::ostream& out) : out_(out) {}
+
+  template <class T>
+  void add(const T& p) {
+    const cpp_int value(p);
+    if (count_ == 0) {
+      const char magic[] = { 'P', 'G', 'A', 'P', 1 };
+      buffer_.insert(buffer_.end(), magic, magic + sizeof(magic));
+      gaps::put_integer(buffer_, value);
+    }
+    else {
+      const std::uint64_t gap = static_cast<std::uint64_t>(value - last_);
+      gaps::put_varint(buffer_, gap == 1 ? 0 : gap / 2);
+    }
+    if (count_ % GAP_BLOCK == 0) {
+      gaps::put_u64(index_, written_ + buffer_.size());
+      gaps::put_integer(index_, value);
+    }
+    last_ = value;
+    ++count_;
+    if (buffer_.size() >= (1u << 16)) flush();
+  }
+
+  void finish() {
+    if (count_ == 0) {
+      const char magic[] = { 'P', 'G', 'A', 'P', 1, 0 };
+      buffer_.insert(buffer_.end(), magic, magic + sizeof(magic));
+    }
+    const std::uint64_t index_at = written_ + buffer_.size();
+    buffer_.insert(buffer_.end(), index_.begin(), index_.end());
+    gaps::put_u64(buffer_, index_at);
+    gaps::put_u64(buffer_, count_);
+    const char magic[] = { 'P', 'G', 'I', 'X' };
+    buffer_.insert(buffer_.end(), magic, magic + sizeof(magic));
+    flush();
+    out_.flush();
+  }
+
+private:
+  void flush() {
+    out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    written_ += buffer_.size();
+    buffer_.clear();
+  }
+
+  std::ostream& out_;
+  std::vector<unsigned char> buffer_, index_;
+  std::uint64_t written_ = 0, count_ = 0;
+  cpp_int last_;
+};
+
+// Relit un conteneur depuis un flux positionnable : seuls la fin et l'index sont lus à
+// la construction, read() reprend au bloc du rang demandé. Lève std::runtime_error si
+// le fichier est invalide.
+class GapReader {
+public:
+  explicit GapReader(std::istream& in) : in_(in) {
+    in_.seekg(0, std::ios::end);
+    const std::streamoff size = in_.tellg();
+    char head[4] = {}, tail[20] = {};
+    if (size >= 26) {
+      in_.seekg(0);
+      in_.read(head, sizeof(head));
+      in_.seekg(size - 20);
+      in_.read(tail, sizeof(tail));
+    }
+    if (size < 26 || !in_ || std::string(head, 4) != "PGAP" || std::string(tail + 16, 4) != "PGIX") {
+      throw std::runtime_error("fichier de premiers invalide");
+    }
+    end_ = static_cast<std::uint64_t>(size) - 20;
+    gaps::Cursor trailer(in_, end_, end_ + 16);
+    index_at_ = trailer.u64();
+    count_ = trailer.u64();
+    if (index_at_ > end_) throw std::runtime_error("fichier de premiers invalide");
+    gaps::Cursor index(in_, index_at_, end_);
+    for (std::uint64_t b = 0; b < (count_ + GAP_BLOCK - 1) / GAP_BLOCK; ++b) {
+      offset_.push_back(index.u64());
+      start_.push_back(index.integer());
+    }
+  }
+
+  std::uint64_t size() const { return count_; }
+
+  // Passe à emit les premiers de rang [first, first + count) ; renvoie leur nombre.
+  template <class Emit>
+  std::uint64_t read(std::uint64_t first, std::uint64_t count, Emit&& emit) {
+    if (first >= count_) return 0;
+    count = std::min(count, count_ - first);
+    const std::size_t block = static_cast<std::size_t>(first / GAP_BLOCK);
+    cpp_int p = start_[block];
+    gaps::Cursor cursor(in_, offset_[block], index_at_);
+    for (std::uint64_t i = block * GAP_BLOCK; i < first + count; ++i) {
+      if (i != block * GAP_BLOCK) {
+        const std::uint64_t half = cursor.varint();
+        p += half == 0 ? 1 : 2 * half;
+      }
+      if (i >= first) emit(p);
+    }
+    return count;
+  }
+
+private:
+  std::istream& in_;
+  std::uint64_t end_ = 0, index_at_ = 0, count_ = 0;
+  std::vector<std::uint64_t> offset_;
+  std::vector<cpp_int> start_;
+};
+
+} // namespace primes
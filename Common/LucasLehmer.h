@@ -0,0 +1,122 @@
+// LucasLehmer.h
+// Tests déterministes pour N = k·2^n - 1 (k impair, k < 2^n) :
+//  - k = 1 (Mersenne 2^n - 1, n premier) : Lucas-Lehmer, u_0 = 4 ;
+//  - k > 1 : Lucas-Lehmer-Riesel, u_0 = V_k(P, 1) mod N avec (P-2 / N) = 1 et
+//    (P+2 / N) = -1 (Rödseth).
+// Puis u_i = u_{i-1}^2 - 2 : N est premier si et seulement si u_{n-2} = 0 (mod N).
+// La réduction modulo N est celle de K2nModulus (décalages et additions pour k = 1),
+// les carrés passent par ntt::mul. Candidats criblés sur k (KSieve) ou sur n (NSieve).
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Arithmetic.h"
+#include "PrimeEngine.h"
+#include "Proth.h"
+#include "WorkStealingPool.h"
+
+namespace primes {
+
+// Symbole de Jacobi (a / n) pour un petit a et un grand n impair, par réciprocité.
+inline int jacobi(u64 a, const cpp_int& n) {
+  int t = 1;
+  const u64 n8 = static_cast<u64>(n & 7);
+  while (a != 0 && (a & 1) == 0) {
+    a >>= 1;
+    if (n8 == 3 || n8 == 5) t = -t;
+  }
+  if (a == 0) return 0;
+  if (a == 1) return t;
+  if ((a & 3) == 3 && (n8 & 3) == 3) t = -t;
+  return t * jacobi(static_cast<u64>(n % a), a);
+}
+
+// Test de Lucas-Lehmer (k = 1) ou de Lucas-Lehmer-Riesel pour k·2^n - 1.
+// Résultat prouvé ; sans P convenable parmi les petits entiers, repli sur Miller-Rabin.
+inline bool llr_prime(u64 k, unsigned n) {
+  if (n < 64 && k < (u64(1) << (63 - n))) return PrimeEngine<Arith64>().is_prime((k << n) - 1);
+  if (k == 1 && !PrimeEngine<Arith32>().is_prime(n)) return false; // 2^a·b - 1 divisible par 2^a - 1
+
+  const K2nModulus mod(k, n, -1);
+  const cpp_int& N = mod.value();
+  auto minus = [&N](const cpp_int& x, u32 c) { return x >= c ? cpp_int(x - c) : cpp_int(x + N - c); };
+
+  cpp_int u = 4;
+  if (k != 1) {
+    u32 P = 3;
+    while (P < 1000 && !(jacobi(P - 2, N) == 1 && jacobi(P + 2, N) == -1)) ++P;
+    if (P == 1000) return BigArith().probable_prime(N);
+    // V_k par la chaîne de Lucas (V_m, V_m+1) : V_2m = V_m^2 - 2, V_2m+1 = V_m·V_m+1 - P
+    cpp_int v = P, w = P * P - 2;
+    int bit = 63;
+    while (((k >> bit) & 1) == 0) --bit;
+    while (bit-- > 0) {
+      if ((k >> bit) & 1) {
+        v = minus(mod.mul(v, w), P);
+        w = minus(mod.sqr(w), 2);
+      }
+      else {
+        w = minus(mod.mul(v, w), P);
+        v = minus(mod.sqr(v), 2);
+      }
+    }
+    u = v;
+  }
+  for (unsigned i = 2; i < n; ++i) u = minus(mod.sqr(u), 2);
+  return u == 0;
+}
+
+// Émet dans l'ordre les k impairs de [k_lo, k_hi] (k_hi < 2^n) pour lesquels
+// k·2^n - 1 est premier ; renvoie leur nombre.
+template <class Emit>
+inline std::size_t riesel_search_k(u64 k_lo, u64 k_hi, unsigned n, Emit&& emit, WorkStealingPool* pool = nullptr) {
+  const KSieve ksieve(n, -1);
+  std::vector<char> composite(KSIEVE_WINDOW);
+  std::size_t found = 0;
+  for (u64 k0 = k_lo | 1; k0 <= k_hi;) {
+    const std::size_t len = static_cast<std::size_t>(std::min<u64>(KSIEVE_WINDOW - 1, (k_hi - k0) / 2) + 1);
+    ksieve.sieve(k0, len, composite.data());
+    std::vector<u64> survivors;
+    for (std::size_t j = 0; j < len; ++j) {
+      if (!composite[j]) survivors.push_back(k0 + 2 * j);
+    }
+    const std::vector<char> prime = test_survivors(survivors, [n](u64 k) { return llr_prime(k, n); }, pool);
+    for (std::size_t i = 0; i < survivors.size(); ++i) {
+      if (prime[i]) { emit(survivors[i]); ++found; }
+    }
+    if (k_hi - k0 < 2 * u64(len)) break;
+    k0 += 2 * u64(len);
+  }
+  return found;
+}
+
+// Émet dans l'ordre les n de [n_lo, n_hi] (2^n > k) pour lesquels k·2^n - 1 est
+// premier (k = 1 : exposants de Mersenne) ; renvoie leur nombre.
+template <class Emit>
+inline std::size_t riesel_search_n(u64 k, unsigned n_lo, unsigned n_hi, Emit&& emit, WorkStealingPool* pool = nullptr) {
+  const NSieve nsieve(k, -1);
+  std::vector<char> composite(KSIEVE_WINDOW);
+  std::size_t found = 0;
+  for (u64 n0 = n_lo; n0 <= n_hi; n0 += KSIEVE_WINDOW) {
+    const std::size_t len = static_cast<std::size_t>(std::min<u64>(KSIEVE_WINDOW, n_hi - n0 + 1));
+    nsieve.sieve(static_cast<unsigned>(n0), len, composite.data());
+    std::vector<u64> survivors;
+    for (std::size_t j = 0; j < len; ++j) {
+      const unsigned n = static_cast<unsigned>(n0 + j);
+      if (composite[j] || (k == 1 && !PrimeEngine<Arith32>().is_prime(n))) continue;
+      survivors.push_back(n);
+    }
+    const std::vector<char> prime =
+      test_survivors(survivors, [k](u64 n) { return llr_prime(k, static_cast<unsigned>(n)); }, pool);
+    for (std::size_t i = 0; i < survivors.size(); ++i) {
+      if (prime[i]) { emit(static_cast<unsigned>(survivors[i])); ++found; }
+    }
+  }
+  return found;
+}
+
+} // namespace primes
@@ -0,0 +1,71 @@
+// MultiResidue.h
+// Calcule n mod p pour tous les petits premiers de SMALL_PRIMES en une seule
+// lecture des limbs de n (cpp_int), au lieu d'une division multiprécision par premier.
+//
+// Schéma de Horner en base 2^16 : r <- (r * 2^16 + chiffre) mod p. Comme p < 2^16,
+// tout tient sur 32 bits et la réduction est un Barrett 32 bits sans branche.
+// La boucle interne parcourt les premiers (structure de tableaux) : chaque premier
+// est une voie SIMD indépendante, que le compilateur vectorise en -O2/-O3 (/O2).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "SmallPrimes.h"
+
+namespace primes {
+
+static_assert(SMALL_PRIMES.prime[SMALL_PRIMES.size - 1] < (1u << 16),
+              "MultiResidue exige des petits premiers < 2^16 (SMALL_PRIMES_COUNT <= 6542)");
+
+class MultiResidue {
+public:
+  static constexpr std::size_t size = SMALL_PRIMES.size;
+
+  MultiResidue() {
+    for (std::size_t i = 0; i < size; ++i) {
+      prime_[i] = SMALL_PRIMES.prime[i];
+      barrett_[i] = static_cast<std::uint32_t>((std::uint64_t(1) << 32) / prime_[i]);
+    }
+  }
+
+  std::uint32_t prime(std::size_t i) const { return prime_[i]; }
+
+  // out[i] = n mod SMALL_PRIMES.prime[i], pour n >= 0.
+  void compute(const boost::multiprecision::cpp_int& n, std::uint32_t* out) const {
+    using boost::multiprecision::limb_type;
+    constexpr unsigned chunks = sizeof(limb_type) * 8 / 16;
+
+    for (std::size_t i = 0; i < size; ++i) out[i] = 0;
+    const limb_type* limbs = n.backend().limbs();
+    for (std::size_t k = n.backend().size(); k-- > 0;) {
+      const limb_type limb = limbs[k];
+      for (unsigned c = chunks; c-- > 0;) {
+        const std::uint32_t digit = static_cast<std::uint32_t>(limb >> (16 * c)) & 0xFFFFu;
+        for (std::size_t i = 0; i < size; ++i) {
+          const std::uint32_t x = (out[i] << 16) | digit;
+          const std::uint32_t q = static_cast<std::uint32_t>((std::uint64_t(x) * barrett_[i]) >> 32);
+          std::uint32_t r = x - q * prime_[i];
+          r -= (r >= prime_[i]) ? prime_[i] : 0;
+          out[i] = r;
+        }
+      }
+    }
+  }
+
+  std::vector<std::uint32_t> compute(const boost::multiprecision::cpp_int& n) const {
+    std::vector<std::uint32_t> out(size);
+    compute(n, out.data());
+    return out;
+  }
+
+private:
+  alignas(64) std::uint32_t prime_[size];
+  alignas(64) std::uint32_t barrett_[size];
+};
+
+} // namespace primes
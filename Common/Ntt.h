@@ -0,0 +1,450 @@
+// Ntt.h
+// Multiplication de grands entiers (cpp_int) par transformée de Fourier modulaire
+// (NTT) sur trois premiers c·2^k + 1, recombinés par restes chinois (Garner).
+//
+// Chiffres de 32 bits : un coefficient du produit vaut au plus len · (2^32 - 1)^2,
+// ce qui reste sous P0·P1·P2 ≈ 2^86 tant que le plus petit opérande fait au plus
+// 2^22 chiffres (128 Mbits). Les trois transformées sont indépendantes : au-delà de
+// NTT_PARALLEL_MIN points, chacune tourne sur son thread. Chaque transformée fait
+// ses étages longs sur tout le tableau, puis finit bloc par bloc (NTT_BLOCK points,
+// qui tiennent dans le cache L2).
+//
+// Transformée directe DIF (sortie en ordre bit-inversé) et inverse DIT (entrée en
+// ordre bit-inversé) : le produit point à point se passe de permutation.
+//
+// NttModulus : réduction de Barrett modulo m ; les transformées de m et de
+// floor(4^k / m) sont faites une fois pour toutes. powmod_ntt y enchaîne les carrés
+// (une seule transformée directe) et les produits par la base, elle aussi transformée
+// une seule fois. powmod (Arithmetic.h) bascule dessus à partir de ntt_threshold_bits().
+// powmod_gerbicz ajoute le contrôle d'erreurs de Gerbicz-Li aux très longues exponentiations.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#ifndef NTT_THRESHOLD_BITS
+#define NTT_THRESHOLD_BITS 16384
+#endif
+
+namespace primes {
+
+using boost::multiprecision::cpp_int;
+
+// Taille de module (en bits) à partir de laquelle powmod passe par la NTT.
+inline std::atomic<unsigned>& ntt_threshold_bits() {
+  static std::atomic<unsigned> bits(NTT_THRESHOLD_BITS);
+  return bits;
+}
+
+namespace ntt {
+
+using std::uint32_t;
+using std::uint64_t;
+
+constexpr std::size_t NTT_BLOCK = 1u << 14;        // 3 × 64 Ko
+constexpr std::size_t NTT_PARALLEL_MIN = 1u << 15; // en dessous, un seul thread
+constexpr std::size_t MAX_LENGTH = 1u << 23;        // limite de P0 = 119·2^23 + 1
+
+constexpr uint32_t P0 = 998244353; // 119·2^23 + 1
+constexpr uint32_t P1 = 469762049; // 7·2^26 + 1
+constexpr uint32_t P2 = 167772161; // 5·2^25 + 1
+
+// Arithmétique modulo un premier connu à la compilation : le compilateur remplace
+// la division par une multiplication.
+template <uint32_t P>
+struct Field {
+  static constexpr uint32_t add(uint32_t a, uint32_t b) { const uint32_t s = a + b; return s >= P ? s - P : s; }
+  static constexpr uint32_t sub(uint32_t a, uint32_t b) { return a >= b ? a - b : a + P - b; }
+  static constexpr uint32_t mul(uint32_t a, uint32_t b) { return static_cast<uint32_t>(uint64_t(a) * b % P); }
+  static constexpr uint32_t pow(uint32_t a, uint64_t e) {
+    uint32_t r = 1;
+    for (; e != 0; e >>= 1, a = mul(a, a)) {
+      if (e & 1) r = mul(r, a);
+    }
+    return r;
+  }
+  static constexpr uint32_t inv(uint32_t a) { return pow(a, P - 2); }
+};
+
+// Racines de l'unité d'un premier, rangées par niveau : roots[half + j] = w_{2·half}^j.
+template <uint32_t P>
+class Transform {
+public:
+  using F = Field<P>;
+  static constexpr uint32_t GENERATOR = 3; // racine primitive des trois premiers
+
+  // Tables valables pour toute longueur <= len : agrandies à la demande, les
+  // anciennes restant en vie tant qu'un appelant s'en sert.
+  static std::shared_ptr<const Transform> get(std::size_t len) {
+    static std::mutex mutex;
+    static std::shared_ptr<const Transform> current;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!current || current->size_ < len) {
+      current.reset(new Transform(std::max<std::size_t>(len, current ? 2 * current->size_ : 2)));
+    }
+    return current;
+  }
+
+  void forward(uint32_t* a, std::size_t n) const {
+    std::size_t half = n / 2;
+    for (; half >= 1 && 2 * half > NTT_BLOCK; half /= 2) dif_stage(a, n, half);
+    for (std::size_t b = 0; b < n; b += 2 * half) {
+      for (std::size_t h = half; h >= 1; h /= 2) dif_stage(a + b, 2 * half, h);
+    }
+  }
+
+  void inverse(uint32_t* a, std::size_t n) const {
+    const std::size_t block = std::min(n, NTT_BLOCK);
+    for (std::size_t b = 0; b < n; b += block) {
+      for (std::size_t h = 1; h < block; h *= 2) dit_stage(a + b, block, h);
+    }
+    for (std::size_t h = block; h < n; h *= 2) dit_stage(a, n, h);
+    const uint32_t scale = F::inv(static_cast<uint32_t>(n % P));
+    for (std::size_t i = 0; i < n; ++i) a[i] = F::mul(a[i], scale);
+  }
+
+private:
+  explicit Transform(std::size_t max_len) : size_(max_len), roots_(max_len), iroots_(max_len) {
+    for (std::size_t half = 1; half < max_len; half *= 2) {
+      const uint32_t w = F::pow(GENERATOR, (P - 1) / (2 * half));
+      const uint32_t iw = F::inv(w);
+      uint32_t x = 1, ix = 1;
+      for (std::size_t j = 0; j < half; ++j) {
+        roots_[half + j] = x;
+        iroots_[half + j] = ix;
+        x = F::mul(x, w);
+        ix = F::mul(ix, iw);
+      }
+    }
+  }
+
+  void dif_stage(uint32_t* a, std::size_t n, std::size_t half) const {
+    const uint32_t* w = roots_.data() + half;
+    for (std::size_t i = 0; i < n; i += 2 * half) {
+      for (std::size_t j = 0; j < half; ++j) {
+        const uint32_t u = a[i + j], v = a[i + j + half];
+        a[i + j] = F::add(u, v);
+        a[i + j + half] = F::mul(F::sub(u, v), w[j]);
+      }
+    }
+  }
+
+  void dit_stage(uint32_t* a, std::size_t n, std::size_t half) const {
+    const uint32_t* w = iroots_.data() + half;
+    for (std::size_t i = 0; i < n; i += 2 * half) {
+      for (std::size_t j = 0; j < half; ++j) {
+        const uint32_t u = a[i + j], v = F::mul(a[i + j + half], w[j]);
+        a[i + j] = F::add(u, v);
+        a[i + j + half] = F::sub(u, v);
+      }
+    }
+  }
+
+  std::size_t size_;
+  std::vector<uint32_t> roots_, iroots_;
+};
+
+// Lance f(0), f(1), f(2) : en parallèle si la transformée est assez longue.
+template <class Fn>
+inline void for_each_prime(std::size_t len, Fn&& f) {
+  if (len < NTT_PARALLEL_MIN) {
+    f(0); f(1); f(2);
+    return;
+  }
+  std::thread t1([&f] { f(1); });
+  std::thread t2([&f] { f(2); });
+  f(0);
+  t1.join();
+  t2.join();
+}
+
+inline std::size_t digit_count(const cpp_int& a) {
+  return a == 0 ? 0 : (boost::multiprecision::msb(a) / 32 + 1);
+}
+
+// Plus petite longueur de transformée pour un produit de da + db chiffres.
+inline std::size_t transform_length(std::size_t digits) {
+  std::size_t len = 2;
+  while (len < digits) len <<= 1;
+  return len;
+}
+
+// Opérande transformé modulo les trois premiers, à une longueur donnée.
+class Transformed {
+public:
+  Transformed() = default;
+
+  Transformed(const cpp_int& a, std::size_t len) : len_(len) {
+    using boost::multiprecision::limb_type;
+    constexpr unsigned chunks = sizeof(limb_type) / sizeof(uint32_t);
+    std::vector<uint32_t> digits(len, 0);
+    const limb_type* limbs = a.backend().limbs();
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < a.backend().size() && k < len; ++i) {
+      for (unsigned c = 0; c < chunks && k < len; ++c) {
+        digits[k++] = static_cast<uint32_t>(limbs[i] >> (32 * c));
+      }
+    }
+    for_each_prime(len, [&](int p) {
+      residue_[p] = digits;
+      reduce_and_forward(p);
+    });
+  }
+
+  std::size_t length() const { return len_; }
+
+  // Produit point à point avec b (même longueur) puis transformées inverses.
+  cpp_int multiply(const Transformed& b) const {
+    Transformed r;
+    r.len_ = len_;
+    for_each_prime(len_, [&](int p) {
+      r.residue_[p].resize(len_);
+      for (std::size_t i = 0; i < len_; ++i) r.residue_[p][i] = pointwise(p, residue_[p][i], b.residue_[p][i]);
+      r.backward(p);
+    });
+    return r.recombine();
+  }
+
+  cpp_int square() const { return multiply(*this); }
+
+private:
+  static uint32_t pointwise(int p, uint32_t a, uint32_t b) {
+    return p == 0 ? Field<P0>::mul(a, b) : p == 1 ? Field<P1>::mul(a, b) : Field<P2>::mul(a, b);
+  }
+
+  void reduce_and_forward(int p) {
+    std::vector<uint32_t>& v = residue_[p];
+    if (p == 0) { for (uint32_t& x : v) x %= P0; Transform<P0>::get(len_)->forward(v.data(), len_); }
+    else if (p == 1) { for (uint32_t& x : v) x %= P1; Transform<P1>::get(len_)->forward(v.data(), len_); }
+    else { for (uint32_t& x : v) x %= P2; Transform<P2>::get(len_)->forward(v.data(), len_); }
+  }
+
+  void backward(int p) {
+    uint32_t* v = residue_[p].data();
+    if (p == 0) Transform<P0>::get(len_)->inverse(v, len_);
+    else if (p == 1) Transform<P1>::get(len_)->inverse(v, len_);
+    else Transform<P2>::get(len_)->inverse(v, len_);
+  }
+
+  // Garner : x = a0 + P0·(a1 + P1·a2), puis propagation des retenues en base 2^32.
+  // a0 + P0·t_lo < 2^62 et P0·t_hi < 2^54 : tout tient dans des mots de 64 bits.
+  cpp_int recombine() const {
+    constexpr uint32_t INV_P0_MOD_P1 = Field<P1>::inv(P0 % P1);
+    constexpr uint32_t INV_P0P1_MOD_P2 = Field<P2>::inv(static_cast<uint32_t>(uint64_t(P0) * P1 % P2));
+    std::vector<uint32_t> out(len_ + 2, 0);
+    uint64_t carry = 0;
+    for (std::size_t i = 0; i < len_; ++i) {
+      const uint32_t a0 = residue_[0][i];
+      const uint32_t a1 = Field<P1>::mul(Field<P1>::sub(residue_[1][i], a0 % P1), INV_P0_MOD_P1);
+      const uint32_t partial = static_cast<uint32_t>((a0 + uint64_t(P0 % P2) * a1) % P2);
+      const uint32_t a2 = Field<P2>::mul(Field<P2>::sub(residue_[2][i], partial), INV_P0P1_MOD_P2);
+      const uint64_t t = a1 + uint64_t(P1) * a2;
+      const uint64_t low = a0 + uint64_t(P0) * (t & 0xFFFFFFFFu) + carry;
+      out[i] = static_cast<uint32_t>(low);
+      carry = (low >> 32) + uint64_t(P0) * (t >> 32);
+    }
+    out[len_] = static_cast<uint32_t>(carry);
+    out[len_ + 1] = static_cast<uint32_t>(carry >> 32);
+    cpp_int r;
+    boost::multiprecision::import_bits(r, out.begin(), out.end(), 32, false);
+    return r;
+  }
+
+  std::size_t len_ = 0;
+  std::array<std::vector<uint32_t>, 3> residue_;
+};
+
+inline cpp_int multiply(const cpp_int& a, const cpp_int& b) {
+  const std::size_t len = transform_length(digit_count(a) + digit_count(b));
+  if (&a == &b || a == b) return Transformed(a, len).square();
+  return Transformed(a, len).multiply(Transformed(b, len));
+}
+
+inline cpp_int square(const cpp_int& a) {
+  return Transformed(a, transform_length(2 * digit_count(a))).square();
+}
+
+// Produit de a et b (en chiffres de 32 bits) à la portée de la NTT ?
+inline bool fits(std::size_t digits_a, std::size_t digits_b) {
+  return std::min(digits_a, digits_b) <= MAX_LENGTH / 2 && transform_length(digits_a + digits_b) <= MAX_LENGTH;
+}
+
+// Produit : NTT au-delà du seuil, sinon multiplication de Boost.
+inline cpp_int mul(const cpp_int& a, const cpp_int& b) {
+  const unsigned threshold = ntt_threshold_bits().load(std::memory_order_relaxed);
+  if (a == 0 || b == 0 || boost::multiprecision::msb(a) < threshold || boost::multiprecision::msb(b) < threshold ||
+      !fits(digit_count(a), digit_count(b))) {
+    return a * b;
+  }
+  return multiply(a, b);
+}
+
+} // namespace ntt
+
+// Réduction de Barrett modulo m (k bits) : mu = floor(4^k / m) calculé par Newton,
+// transformées de m et de mu gardées pour tous les produits.
+class NttModulus {
+public:
+  explicit NttModulus(const cpp_int& m)
+      : m_(m), k_(boost::multiprecision::msb(m) + 1),
+        len_(ntt::transform_length(2 * ((k_ + 1) / 32 + 1))),
+        mu_(reciprocal(m, k_)), m_hat_(m_, len_), mu_hat_(mu_, len_) {}
+
+  const cpp_int& modulus() const { return m_; }
+  std::size_t length() const { return len_; }
+
+  // x < m^2
+  cpp_int reduce(const cpp_int& x) const {
+    cpp_int r;
+    divide(x, r);
+    return r;
+  }
+
+  // Quotient de x < m^2 par m, reste dans r.
+  cpp_int divide(const cpp_int& x, cpp_int& r) const {
+    cpp_int q = ntt::Transformed(x >> (k_ - 1), len_).multiply(mu_hat_) >> (k_ + 1);
+    r = x - ntt::Transformed(q, len_).multiply(m_hat_);
+    while (r >= m_) { r -= m_; ++q; }
+    return q;
+  }
+
+  ntt::Transformed transform(const cpp_int& a) const { return ntt::Transformed(a, len_); }
+
+  cpp_int sqr(const cpp_int& a) const { return reduce(transform(a).square()); }
+  cpp_int mul(const cpp_int& a, const ntt::Transformed& b) const { return reduce(transform(a).multiply(b)); }
+  cpp_int mul(const cpp_int& a, const cpp_int& b) const { return mul(a, transform(b)); }
+
+private:
+  // floor(2^(2k) / m) pour m de k bits : Newton à partir de l'inverse de la moitié
+  // haute de m, puis correction exacte (quelques pas au plus).
+  static cpp_int reciprocal(const cpp_int& m, unsigned k) {
+    if (k <= 4096) return (cpp_int(1) << (2 * k)) / m;
+    const unsigned h = k / 2 + 1;
+    const cpp_int y = reciprocal(m >> (k - h), h) << (k - h);
+    const cpp_int e = (cpp_int(1) << (2 * k)) - ntt::mul(m, y);
+    cpp_int x = y + (e < 0 ? -(ntt::mul(y, cpp_int(-e)) >> (2 * k)) - 1 : ntt::mul(y, e) >> (2 * k));
+    cpp_int r = (cpp_int(1) << (2 * k)) - ntt::mul(m, x);
+    while (r < 0) { --x; r += m; }
+    while (r >= m) { ++x; r -= m; }
+    return x;
+  }
+
+  cpp_int m_;
+  unsigned k_;
+  std::size_t len_;
+  cpp_int mu_;
+  ntt::Transformed m_hat_, mu_hat_;
+};
+
+// powmod modulo m passe-t-il par la NTT ?
+inline bool use_ntt_powmod(const cpp_int& m) {
+  if (m <= 1) return false;
+  const std::size_t digits = ntt::digit_count(m) + 1;
+  return boost::multiprecision::msb(m) + 1 >= ntt_threshold_bits().load(std::memory_order_relaxed) &&
+         ntt::fits(digits, digits);
+}
+
+// base^exp mod m, carrés et produits par NTT (binaire de gauche à droite).
+// Si cancel passe à vrai, s'interrompt (résultat alors sans signification).
+inline cpp_int powmod_ntt(const cpp_int& base, const cpp_int& exp, const NttModulus& mod,
+                          const std::atomic<bool>* cancel = nullptr) {
+  const cpp_int b = base % mod.modulus();
+  if (exp == 0) return cpp_int(1) % mod.modulus();
+  const ntt::Transformed b_hat = mod.transform(b);
+  cpp_int r = b;
+  for (unsigned i = boost::multiprecision::msb(exp); i-- > 0;) {
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) break;
+    r = mod.sqr(r);
+    if (boost::multiprecision::bit_test(exp, i)) r = mod.mul(r, b_hat);
+  }
+  return r;
+}
+
+// Compteurs de powmod_gerbicz.
+struct GerbiczStats {
+  std::size_t checks = 0;
+  std::size_t rollbacks = 0;
+};
+
+// base^exp mod m avec contrôle de Gerbicz-Li : l'exposant est lu par blocs de B bits,
+// x_{i+1} = x_i^(2^B) · base^(c_{i+1}) (c : valeur du bloc). Depuis le dernier point
+// vérifié s, D_j = x_s · x_{s+1} ··· x_j ; toutes les L étapes (et à la fin) on vérifie
+//   D_j = x_s · D_{j-1}^(2^B) · base^(c_{s+1} + ... + c_j)
+// ce qui coûte environ 2B carrés pour L·B carrés calculés ; un écart (erreur matérielle)
+// fait repartir du dernier point vérifié. block = 0 : B = L = racine du nombre de bits
+// (surcoût de l'ordre de 3 / B). La base 2 est multipliée par un décalage.
+inline cpp_int powmod_gerbicz(const cpp_int& base, const cpp_int& exp, const NttModulus& mod, unsigned block = 0,
+                              const std::atomic<bool>* cancel = nullptr, GerbiczStats* stats = nullptr) {
+  const cpp_int& m = mod.modulus();
+  const cpp_int b = base % m;
+  if (exp == 0) return cpp_int(1) % m;
+  const unsigned bits = boost::multiprecision::msb(exp) + 1;
+  if (block == 0) {
+    block = 8;
+    while (block * block < bits) ++block;
+  }
+  const unsigned checks_every = block;
+  const ntt::Transformed b_hat = mod.transform(b);
+  auto times_base = [&](const cpp_int& x) {
+    if (b != 2) return mod.mul(x, b_hat);
+    cpp_int y = x << 1;
+    return y >= m ? cpp_int(y - m) : y;
+  };
+  // x^(2^block) · base^c, bits de c du poids fort au poids faible
+  auto step = [&](cpp_int x, const cpp_int& c, unsigned width) {
+    for (unsigned i = width; i-- > 0;) {
+      x = mod.sqr(x);
+      if (boost::multiprecision::bit_test(c, i)) x = times_base(x);
+    }
+    return x;
+  };
+  auto chunk = [&exp, block](unsigned j) { // j-ième bloc de bits sous le bloc de tête
+    return cpp_int((exp >> (block * j)) & ((cpp_int(1) << block) - 1));
+  };
+
+  // bloc de tête : les bits au-dessus du dernier multiple de block
+  const unsigned blocks = (bits - 1) / block;
+  cpp_int x = powmod_ntt(b, exp >> (block * blocks), mod, cancel);
+  cpp_int saved_x = x, d = x, d_prev, sum = 0;
+  unsigned saved = blocks, since = 0;
+  for (unsigned j = blocks; j-- > 0;) {
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) break;
+    const cpp_int c = chunk(j);
+    x = step(x, c, block);
+    sum += c;
+    d_prev = d;
+    d = mod.mul(d, x);
+    if (++since < checks_every && j != 0) continue;
+
+    if (stats != nullptr) ++stats->checks;
+    cpp_int expected = d_prev;
+    for (unsigned i = 0; i < block; ++i) expected = mod.sqr(expected);
+    expected = mod.mul(mod.mul(expected, saved_x), powmod_ntt(b, sum, mod, cancel));
+    if (expected == d) {
+      saved = j;
+      saved_x = x;
+      d = x;
+    }
+    else {
+      if (stats != nullptr) ++stats->rollbacks;
+      j = saved;
+      x = saved_x;
+      d = x;
+    }
+    sum = 0;
+    since = 0;
+  }
+  return x;
+}
+
+} // namespace primes
@@ -0,0 +1,126 @@
+// Pipeline.h
+// File bornée sans verrou multi-producteurs / multi-consommateurs (schéma de Vyukov :
+// un numéro de séquence par case, une seule opération CAS par push ou pop), qui relie
+// les étages du pipeline crible -> test -> sortie de PrimeEngine::generate_pipelined.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace primes {
+
+// Attente d'un étage du pipeline sur une file vide ou pleine : quelques tours actifs,
+// puis yield, puis des pauses croissantes (jusqu'à MAX_PAUSE), pour qu'un étage sans
+// travail ne garde pas son cœur occupé. reset() après chaque progression.
+class Backoff {
+public:
+  static constexpr unsigned SPINS = 64, YIELDS = 64;
+  static constexpr std::chrono::microseconds MIN_PAUSE{ 10 }, MAX_PAUSE{ 500 };
+
+  void wait() {
+    if (tries_ < SPINS) ++tries_;
+    else if (tries_ < SPINS + YIELDS) {
+      ++tries_;
+      std::this_thread::yield();
+    }
+    else {
+      std::this_thread::sleep_for(pause_);
+      pause_ = std::min(2 * pause_, MAX_PAUSE);
+    }
+  }
+
+  void reset() {
+    tries_ = 0;
+    pause_ = MIN_PAUSE;
+  }
+
+private:
+  unsigned tries_ = 0;
+  std::chrono::microseconds pause_ = MIN_PAUSE;
+};
+
+template <class T>
+class BoundedQueue {
+public:
+  // capacity : arrondie à la puissance de 2 supérieure
+  explicit BoundedQueue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) size <<= 1;
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (std::size_t i = 0; i < size; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  bool try_push(T& value) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) return false; // pleine
+      else pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+
+  bool try_pop(T& value) {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          value = std::move(cell.value);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) return false; // vide
+      else pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Versions bloquantes (Backoff) ; abandonnent si `stop` passe à vrai.
+  bool push(T& value, const std::atomic<bool>& stop) {
+    for (Backoff backoff; !try_push(value); backoff.wait()) {
+      if (stop.load(std::memory_order_relaxed)) return false;
+    }
+    return true;
+  }
+
+  bool pop(T& value, const std::atomic<bool>& stop) {
+    for (Backoff backoff; !try_pop(value); backoff.wait()) {
+      if (stop.load(std::memory_order_relaxed)) return false;
+    }
+    return true;
+  }
+
+private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_ = 0;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+} // namespace primes
@@ -0,0 +1,197 @@
+// PrimeBatch.h
+// Test de primalité d'une liste de valeurs quelconques (non consécutives), par lots :
+// is_prime_batch(n, len, out, opt, pool) remplit out[i] = n[i] premier, dans l'ordre
+// des entrées, pour des u64 ou des cpp_int.
+//
+//  - u64 : blocs de BATCH_BLOCK valeurs ; la division d'essai parcourt les petits
+//    premiers par passes de TRIAL_STAGE, en boucle externe, et le bloc en boucle
+//    interne (une multiplication par l'inverse mod 2^64 et une comparaison par valeur,
+//    sans branche : vectorisée en -O3), le bloc étant compacté entre deux passes ; les
+//    survivants > 2^32 passent ensemble par probable_prime_batch (Arith64).
+//  - cpp_int : entrées regroupées par largeur (64, 128, 256, 512, 1024 bits, au-delà),
+//    chaque groupe testé par l'arithmétique de PrimeTester ; restes de tous les petits
+//    premiers en une lecture (MultiResidue) avant Miller-Rabin.
+//
+// Avec un pool (ou opt.threads != 1), les blocs et les grands entiers sont répartis
+// par parallel_for, chaque thread ayant ses propres politiques (graine dérivée).
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "Arithmetic.h"
+#include "PrimeEngine.h"
+#include "SmallPrimes.h"
+#include "WorkStealingPool.h"
+
+namespace primes {
+
+// Valeurs par bloc de division d'essai (u64).
+constexpr std::size_t BATCH_BLOCK = 256;
+
+namespace batch {
+
+// sans facteur <= p_max, n < p_max^2 est premier
+constexpr u64 SIEVE_COMPLETE = u64(SMALL_PRIMES.prime[SMALL_PRIMES.size - 1]) * SMALL_PRIMES.prime[SMALL_PRIMES.size - 1];
+
+// Petits premiers par passe de division d'essai : après chaque passe, le bloc est
+// compacté sur ses survivants (un quart environ après la première).
+constexpr std::size_t TRIAL_STAGE = 8;
+
+// Un bloc d'au plus BATCH_BLOCK valeurs.
+inline void test_block(Arith64& arith, const u64* n, std::size_t len, bool* out) {
+  u64 value[BATCH_BLOCK];
+  std::size_t where[BATCH_BLOCK];
+  unsigned char composite[BATCH_BLOCK];
+  bool prime[BATCH_BLOCK];
+  std::size_t alive = 0;
+  for (std::size_t k = 0; k < len; ++k) {
+    out[k] = n[k] == 2;
+    if (n[k] < 3 || (n[k] & 1) == 0) continue;
+    value[alive] = n[k];
+    where[alive++] = k;
+  }
+  // les premiers de la passe en boucle externe, le bloc en boucle interne : une
+  // multiplication et une comparaison par valeur, sans branche (vectorisée)
+  for (std::size_t first = 1; first < SMALL_PRIMES.size && alive > 0; first += TRIAL_STAGE) {
+    std::fill(composite, composite + alive, static_cast<unsigned char>(0));
+    const std::size_t last = std::min(SMALL_PRIMES.size, first + TRIAL_STAGE);
+    for (std::size_t i = first; i < last; ++i) {
+      const u64 inverse = SMALL_PRIMES.inverse[i];
+      const u64 reciprocal = SMALL_PRIMES.reciprocal[i];
+      const u64 p = SMALL_PRIMES.prime[i];
+      for (std::size_t k = 0; k < alive; ++k) {
+        composite[k] |= static_cast<unsigned char>((value[k] * inverse <= reciprocal) & (value[k] != p));
+      }
+    }
+    std::size_t kept = 0;
+    for (std::size_t k = 0; k < alive; ++k) {
+      if (composite[k]) continue;
+      value[kept] = value[k];
+      where[kept++] = where[k];
+    }
+    alive = kept;
+  }
+
+  std::size_t wide = 0;
+  for (std::size_t k = 0; k < alive; ++k) {
+    if (value[k] < SIEVE_COMPLETE) out[where[k]] = true;
+    else if (value[k] <= std::numeric_limits<u32>::max()) out[where[k]] = arith.probable_prime(value[k]);
+    else {
+      value[wide] = value[k];
+      where[wide++] = where[k];
+    }
+  }
+  if (wide == 0) return;
+  arith.probable_prime_batch(value, prime, wide);
+  for (std::size_t j = 0; j < wide; ++j) out[where[j]] = prime[j];
+}
+
+// Largeur de test d'un cpp_int : 0 (<= 64 bits) ... 4 (<= 1024 bits), 5 au-delà.
+inline unsigned width_class(const cpp_int& n) {
+  if (n <= std::numeric_limits<u64>::max()) return 0;
+  const unsigned bits = static_cast<unsigned>(boost::multiprecision::msb(n)) + 1;
+  if (bits <= 128) return 1;
+  if (bits <= 256) return 2;
+  if (bits <= 512) return 3;
+  if (bits <= 1024) return 4;
+  return 5;
+}
+
+// Politiques d'un thread pour les entiers de plus de 64 bits.
+class WideTester {
+public:
+  WideTester(const GenerateOptions& opt, u64 seed)
+    : a128_(configured(Arith128(32, seed), opt)), a256_(configured(FixedArith<256>(32, seed), opt)),
+      a512_(configured(FixedArith<512>(32, seed), opt)), a1024_(configured(FixedArith<1024>(32, seed), opt)),
+      big_(configured(BigArith(32, seed), opt)) {}
+
+  // n > 2^64 de largeur `width` (width_class) ; division d'essai comprise.
+  bool is_prime(const cpp_int& n, unsigned width) {
+    if (small_factor(n) != 0) return false;
+    switch (width) {
+    case 1: return a128_.probable_prime(static_cast<uint128_t>(n));
+    case 2: return a256_.probable_prime(static_cast<fixed_uint<256>>(n));
+    case 3: return a512_.probable_prime(static_cast<fixed_uint<512>>(n));
+    case 4: return a1024_.probable_prime(static_cast<fixed_uint<1024>>(n));
+    default: return big_.probable_prime(n);
+    }
+  }
+
+private:
+  Arith128 a128_;
+  FixedArith<256> a256_;
+  FixedArith<512> a512_;
+  FixedArith<1024> a1024_;
+  BigArith big_;
+};
+
+} // namespace batch
+
+// out[i] = n[i] premier. pool : pool déjà lancé, utilisé à la place d'un pool créé
+// pour l'appel quand opt.threads != 1.
+inline void is_prime_batch(const u64* n, std::size_t len, bool* out, const GenerateOptions& opt = GenerateOptions(),
+                           WorkStealingPool* shared = nullptr) {
+  const Arith64 arith(opt.mr64);
+  const std::size_t blocks = (len + BATCH_BLOCK - 1) / BATCH_BLOCK;
+  std::unique_ptr<WorkStealingPool> owned;
+  if (opt.threads != 1 && shared == nullptr && blocks > 1) owned.reset(new WorkStealingPool(opt.threads));
+  WorkStealingPool* pool = shared != nullptr ? shared : owned.get();
+  auto run = [&](std::size_t lo, std::size_t hi) {
+    Arith64 local = arith.fork(0);
+    for (std::size_t b = lo; b < hi; ++b) {
+      const std::size_t first = b * BATCH_BLOCK;
+      batch::test_block(local, n + first, std::min(BATCH_BLOCK, len - first), out + first);
+    }
+  };
+  if (pool == nullptr || blocks <= 1) run(0, blocks);
+  else pool->parallel_for(0, blocks, 1, run);
+}
+
+inline void is_prime_batch(const cpp_int* n, std::size_t len, bool* out, const GenerateOptions& opt = GenerateOptions(),
+                           WorkStealingPool* shared = nullptr) {
+  // groupes par largeur ; les entrées de 64 bits forment un lot u64
+  std::vector<std::size_t> group[6];
+  std::vector<u64> narrow;
+  for (std::size_t i = 0; i < len; ++i) {
+    const unsigned width = n[i] < 0 ? 0 : batch::width_class(n[i]);
+    group[width].push_back(i);
+    if (width == 0) narrow.push_back(n[i] < 0 ? 0 : static_cast<u64>(n[i]));
+  }
+
+  std::unique_ptr<WorkStealingPool> owned;
+  if (opt.threads != 1 && shared == nullptr && len > BATCH_BLOCK) owned.reset(new WorkStealingPool(opt.threads));
+  WorkStealingPool* pool = shared != nullptr ? shared : owned.get();
+
+  if (!narrow.empty()) {
+    std::unique_ptr<bool[]> prime(new bool[narrow.size()]);
+    is_prime_batch(narrow.data(), narrow.size(), prime.get(), opt, pool);
+    for (std::size_t j = 0; j < narrow.size(); ++j) out[group[0][j]] = prime[j];
+  }
+
+  // plus larges d'abord : les derniers morceaux répartis sont les moins coûteux
+  std::vector<std::size_t> wide;
+  for (unsigned width = 5; width >= 1; --width) wide.insert(wide.end(), group[width].begin(), group[width].end());
+  if (wide.empty()) return;
+  const unsigned threads = pool == nullptr ? 1 : pool->size() + 1;
+  std::vector<std::unique_ptr<batch::WideTester>> testers(threads);
+  auto run = [&](std::size_t lo, std::size_t hi) {
+    const unsigned t = pool == nullptr ? 0 : pool->current_index();
+    if (!testers[t]) testers[t].reset(new batch::WideTester(opt, opt.seed ^ (u64(t) * 0x9E3779B97F4A7C15ull)));
+    for (std::size_t j = lo; j < hi; ++j) {
+      const std::size_t i = wide[j];
+      out[i] = testers[t]->is_prime(n[i], batch::width_class(n[i]));
+    }
+  };
+  if (pool == nullptr) run(0, wide.size());
+  else pool->parallel_for(0, wide.size(), 1, run);
+}
+
+} // namespace primes
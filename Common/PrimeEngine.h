@@ -0,0 +1,613 @@
+// PrimeEngine.h
+// Moteur de recherche de premiers générique en largeur : une seule source pour le
+// pipeline next_candidate -> crible par fenêtres -> probable_prime -> generate_primes,
+// instancié pour chaque politique de Arithmetic.h (u32, u64, u128, FixedArith<Bits>, cpp_int).
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <thread>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Arithmetic.h"
+#include "MultiResidue.h"
+#include "Pipeline.h"
+#include "SmallPrimes.h"
+#include "WorkStealingPool.h"
+
+namespace primes {
+
+// Taille d'une fenêtre du crible, en candidats impairs.
+constexpr std::size_t SIEVE_WINDOW = 4096;
+
+inline const MultiResidue& multi_residue() {
+  static const MultiResidue kernel;
+  return kernel;
+}
+
+// out[i] = n mod SMALL_PRIMES.prime[i]
+template <class T>
+inline void small_residues(const T& n, std::uint32_t* out) {
+  for (std::size_t i = 0; i < SMALL_PRIMES.size; ++i) {
+    out[i] = static_cast<std::uint32_t>(n % SMALL_PRIMES.prime[i]);
+  }
+}
+
+inline void small_residues(const cpp_int& n, std::uint32_t* out) {
+  multi_residue().compute(n, out);
+}
+
+// Plus petit premier de SMALL_PRIMES divisant n, ou 0 s'il n'y en a pas.
+template <class T>
+inline std::uint32_t small_factor(const T& n) {
+  std::uint32_t r[SMALL_PRIMES.size];
+  small_residues(n, r);
+  for (std::size_t i = 0; i < SMALL_PRIMES.size; ++i) {
+    if (r[i] == 0) return SMALL_PRIMES.prime[i];
+  }
+  return 0;
+}
+
+// division d'essai par multiplication (inverse mod 2^64), sans instruction div
+inline std::uint32_t small_factor(u64 n) {
+  for (std::size_t i = 0; i < SMALL_PRIMES.size; ++i) {
+    if (SMALL_PRIMES.divides(i, n)) return SMALL_PRIMES.prime[i];
+  }
+  return 0;
+}
+
+inline std::uint32_t small_factor(u32 n) { return small_factor(u64(n)); }
+
+// Politique fournissant probable_prime_batch (voir Arith64) : nombre de voies, sinon 1.
+template <class Arith, class = void>
+struct batch_lanes : std::integral_constant<unsigned, 1> {};
+template <class Arith>
+struct batch_lanes<Arith, std::void_t<decltype(Arith::lanes)>>
+  : std::integral_constant<unsigned, Arith::lanes> {};
+
+template <class Arith>
+class PrimeEngine {
+public:
+  using value_type = typename Arith::value_type;
+
+  // Largeur bornée (u32, u64, uint128_t, fixed_uint) : generate_primes s'arrête au maximum du type.
+  static constexpr bool bounded = std::numeric_limits<value_type>::is_bounded;
+
+  explicit PrimeEngine(Arith arith = Arith()) : arith_(std::move(arith)) {}
+
+  Arith& arith() { return arith_; }
+
+  bool is_prime(const value_type& n) {
+    if (n < 2) return false;
+    const std::uint32_t p = small_factor(n);
+    if (p != 0) return n == p;
+    // sans facteur <= p_max, n < p_max^2 est premier
+    if (n < value_type(SIEVE_COMPLETE)) return true;
+    return arith_.probable_prime(n);
+  }
+
+  // Renvoie le prochain candidat impair >= n (ou 2)
+  static value_type next_candidate(value_type n) {
+    if (n <= 2) return 2;
+    if ((n & 1) == 0) ++n;
+    return n;
+  }
+
+  // Premiers >= start. Pour un type borné, peut en renvoyer moins que `count`
+  // si le maximum du type est atteint : generate_primes_hybrid prend alors le relais.
+  std::vector<value_type> generate_primes(value_type start, std::size_t count) {
+    std::vector<value_type> primes;
+    primes.reserve(count);
+    generate(start, count, [&primes](const value_type& p) { primes.push_back(p); });
+    return primes;
+  }
+
+  // Même chose, chaque premier étant passé à emit ; renvoie le nombre émis.
+  // Avec un pool (et assez de premiers demandés pour remplir une fenêtre), les
+  // fenêtres du crible sont réparties entre ses threads par vagues ; emit est
+  // toujours appelé depuis le thread appelant, dans l'ordre.
+  template <class Emit>
+  std::size_t generate(value_type start, std::size_t count, Emit&& emit, WorkStealingPool* pool = nullptr) {
+    std::size_t found = 0;
+    if (count == 0) return 0;
+    value_type n = next_candidate(start);
+    if (n == 2) {
+      emit(n);
+      if (++found == count) return found;
+      n = 3;
+    }
+    // quelques premiers : une fenêtre suffit, une vague en testerait d'autres pour rien
+    if (pool != nullptr && first_window(count - found) == SIEVE_WINDOW)
+      return found + generate_parallel(n, count - found, emit, *pool);
+
+    std::vector<char> composite(SIEVE_WINDOW);
+    std::size_t cap = first_window(count);
+    while (found < count) {
+      bool last = false;
+      std::size_t len = window_length(n, last);
+      if (len > cap) {
+        len = cap;
+        last = false;
+      }
+      found += test_window(arith_, n, len, composite.data(), count - found, emit);
+      if (last) break;
+      n += value_type(2 * len);
+      cap = std::min(SIEVE_WINDOW, 2 * cap);
+    }
+    return found;
+  }
+
+  // Premiers <= start, du plus grand au plus petit : les mêmes fenêtres (et la même
+  // répartition sur le pool) parcourues à rebours, chacune testée de haut en bas.
+  // S'arrête après `count` premiers ou sous `lowest` (2 est émis si lowest <= 2) ;
+  // renvoie le nombre émis, qui peut donc être inférieur à `count`.
+  template <class Emit>
+  std::size_t generate_down(value_type start, std::size_t count, Emit&& emit, WorkStealingPool* pool = nullptr,
+                            value_type lowest = 0) {
+    std::size_t found = 0;
+    if (count == 0 || start < 2 || start < lowest) return 0;
+    // candidats impairs de [bottom, top] ; top < bottom si start = 2 ou lowest = start pair
+    const value_type top = (start & 1) == 0 ? value_type(start - 1) : start;
+    const value_type bottom = lowest <= 3 ? value_type(3) : (lowest & 1) == 0 ? value_type(lowest + 1) : lowest;
+    if (top >= bottom) {
+      if (pool != nullptr && first_window(count) == SIEVE_WINDOW) found = generate_parallel(top, count, emit, *pool, bottom);
+      else {
+        std::vector<char> composite(SIEVE_WINDOW);
+        value_type n = top;
+        std::size_t cap = first_window(count);
+        for (;;) {
+          const std::size_t len = std::min(cap, window_below(n, bottom));
+          const value_type base = n - value_type(2 * (len - 1));
+          found += test_window(arith_, base, len, composite.data(), count - found, emit, true);
+          if (found == count || base == bottom) break;
+          n = base - 2;
+          cap = std::min(SIEVE_WINDOW, 2 * cap);
+        }
+      }
+    }
+    if (found < count && lowest <= 2) {
+      emit(value_type(2));
+      ++found;
+    }
+    return found;
+  }
+
+  // Pipeline à trois étages reliés par des files bornées sans verrou : un thread de
+  // crible produit les survivants de chaque fenêtre, `testers` threads les testent et
+  // le thread appelant remet les résultats dans l'ordre (tampon de réordonnancement)
+  // avant de les émettre. Le crible n'occupe pas les cœurs de test et emit (formatage,
+  // sortie) ne bloque pas les calculs. Si emit lève une exception, les threads sont
+  // arrêtés et rejoints avant qu'elle ne se propage.
+  template <class Emit>
+  std::size_t generate_pipelined(value_type start, std::size_t count, Emit&& emit, unsigned testers) {
+    std::size_t found = 0;
+    if (count == 0) return 0;
+    value_type n = next_candidate(start);
+    if (n == 2) {
+      emit(n);
+      if (++found == count) return found;
+      n = 3;
+    }
+    if (testers == 0) testers = std::max(1u, std::thread::hardware_concurrency() - 1);
+
+    struct Batch {
+      std::size_t seq = 0;
+      bool proven = false;
+      std::vector<value_type> values;
+    };
+    BoundedQueue<Batch> survivors(2 * testers + 2), results(2 * testers + 2);
+    std::atomic<bool> stop(false), sieve_done(false);
+    std::atomic<std::size_t> batches(0); // nombre de fenêtres produites, valide après sieve_done
+
+    // arrête et rejoint les threads à la sortie, normale ou par exception
+    std::thread sieve;
+    std::vector<std::thread> workers;
+    struct Joiner {
+      std::atomic<bool>& stop;
+      std::thread& sieve;
+      std::vector<std::thread>& workers;
+      ~Joiner() {
+        stop.store(true);
+        if (sieve.joinable()) sieve.join();
+        for (std::thread& t : workers) {
+          if (t.joinable()) t.join();
+        }
+      }
+    } joiner{ stop, sieve, workers };
+
+    sieve = std::thread([&, n]() mutable {
+      std::vector<char> composite(SIEVE_WINDOW);
+      std::size_t seq = 0;
+      bool last = false;
+      while (!last && !stop.load()) {
+        const std::size_t len = window_length(n, last);
+        sieve_window(n, len, composite.data());
+        Batch b;
+        b.seq = seq;
+        b.proven = window_proven(n, len);
+        for (std::size_t j = 0; j < len; ++j) {
+          if (!composite[j]) b.values.push_back(n + value_type(2 * j));
+        }
+        if (!survivors.push(b, stop)) break;
+        ++seq;
+        if (!last) n += value_type(2 * len);
+      }
+      batches.store(seq);
+      sieve_done.store(true);
+    });
+
+    for (unsigned t = 0; t < testers; ++t) {
+      workers.emplace_back([&, t] {
+        Arith arith = arith_.fork(t);
+        Batch b;
+        Backoff backoff;
+        while (!stop.load()) {
+          if (!survivors.try_pop(b)) {
+            if (!sieve_done.load()) {
+              backoff.wait();
+              continue;
+            }
+            if (!survivors.try_pop(b)) break;
+          }
+          backoff.reset();
+          Batch r;
+          r.seq = b.seq;
+          auto collect = [&r](const value_type& p) { r.values.push_back(p); };
+          test_values(arith, b.values, b.proven, collect);
+          if (!results.push(r, stop)) break;
+        }
+      });
+    }
+
+    std::map<std::size_t, std::vector<value_type>> pending;
+    std::size_t next = 0;
+    Batch r;
+    Backoff backoff;
+    while (found < count) {
+      if (!results.try_pop(r)) {
+        if (sieve_done.load() && next == batches.load()) break;
+        backoff.wait();
+        continue;
+      }
+      backoff.reset();
+      pending.emplace(r.seq, std::move(r.values));
+      for (auto it = pending.find(next); it != pending.end(); it = pending.find(next)) {
+        for (std::size_t k = 0; k < it->second.size() && found < count; ++k) {
+          emit(it->second[k]);
+          ++found;
+        }
+        pending.erase(it);
+        ++next;
+      }
+    }
+    return found;
+  }
+
+  // Raye dans composite[0, len) les candidats n + 2j ayant un facteur impair de
+  // SMALL_PRIMES (n impair) ; les résidus de n donnent le premier multiple de chaque p.
+  static void sieve_window(const value_type& n, std::size_t len, char* composite) {
+    std::uint32_t residues[SMALL_PRIMES.size];
+    small_residues(n, residues);
+    // n petit : les petits premiers >= n figurent dans la fenêtre et ne doivent pas être rayés
+    const std::uint32_t small_base = n <= value_type(MAX_SMALL) ? static_cast<std::uint32_t>(n) : 0;
+    std::fill(composite, composite + len, 0);
+    for (std::size_t i = 1; i < SMALL_PRIMES.size; ++i) {
+      const std::uint64_t p = SMALL_PRIMES.prime[i];
+      // premier j tel que n + 2j = 0 (mod p) : j = -r * 2^-1 mod p
+      std::uint64_t j = (p - residues[i]) % p * ((p + 1) / 2) % p;
+      if (small_base != 0 && p >= small_base) j += p;
+      for (; j < len; j += p) composite[j] = 1;
+    }
+  }
+
+private:
+  // Nombre de candidats de la fenêtre commençant en n ; last si le maximum du type y est atteint.
+  static std::size_t window_length(const value_type& n, bool& last) {
+    last = false;
+    if constexpr (bounded) {
+      const value_type room = (std::numeric_limits<value_type>::max() - n) / 2;
+      if (room < value_type(SIEVE_WINDOW - 1)) {
+        last = true;
+        return static_cast<std::size_t>(room) + 1;
+      }
+    }
+    return SIEVE_WINDOW;
+  }
+
+  // Longueur maximale de la première fenêtre du parcours séquentiel, doublée ensuite
+  // jusqu'à SIEVE_WINDOW : pour quelques premiers (next_prime, prev_prime), cribler une
+  // fenêtre pleine coûte plus que les tests eux-mêmes.
+  static std::size_t first_window(std::size_t count) {
+    return count >= SIEVE_WINDOW / 64 ? SIEVE_WINDOW : std::max<std::size_t>(256, 64 * count);
+  }
+
+  // Nombre de candidats de la fenêtre finissant en n (parcours décroissant), sans
+  // descendre sous bottom (n, bottom impairs, n >= bottom).
+  static std::size_t window_below(const value_type& n, const value_type& bottom) {
+    const value_type room = (n - bottom) / 2;
+    return room < value_type(SIEVE_WINDOW - 1) ? static_cast<std::size_t>(room) + 1 : SIEVE_WINDOW;
+  }
+
+  // Fenêtre entièrement sous p_max^2 : ses survivants sont premiers.
+  static bool window_proven(const value_type& n, std::size_t len) {
+    return n < value_type(SIEVE_COMPLETE) && value_type(SIEVE_COMPLETE) - n >= value_type(2 * len);
+  }
+
+  // Crible puis teste la fenêtre [n, n + 2 len) ; émet dans l'ordre (décroissant si
+  // down) au plus `wanted` premiers et renvoie leur nombre. composite : tampon de
+  // SIEVE_WINDOW octets.
+  template <class Emit>
+  static std::size_t test_window(Arith& arith, const value_type& n, std::size_t len, char* composite,
+                                 std::size_t wanted, Emit& emit, bool down = false) {
+    sieve_window(n, len, composite);
+    const bool complete = window_proven(n, len);
+    if constexpr (batch_lanes<Arith>::value > 1) {
+      if (!complete && n > value_type(std::numeric_limits<u32>::max())) {
+        return test_window_batched(arith, n, len, composite, wanted, emit, down);
+      }
+    }
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < len && found < wanted; ++i) {
+      const std::size_t j = down ? len - 1 - i : i;
+      if (composite[j]) continue;
+      value_type c = n + value_type(2 * j);
+      if (complete || arith.probable_prime(c)) {
+        emit(c);
+        ++found;
+      }
+    }
+    return found;
+  }
+
+  // Teste une liste de survivants (déjà prouvés premiers si proven), émis dans l'ordre.
+  template <class Emit>
+  static void test_values(Arith& arith, const std::vector<value_type>& values, bool proven, Emit& emit) {
+    if (proven) {
+      for (const value_type& c : values) emit(c);
+      return;
+    }
+    if constexpr (batch_lanes<Arith>::value > 1) {
+      if (!values.empty() && values.front() > value_type(std::numeric_limits<u32>::max())) {
+        constexpr std::size_t BATCH = 64;
+        bool prime[BATCH];
+        for (std::size_t i = 0; i < values.size(); i += BATCH) {
+          const std::size_t len = std::min(BATCH, values.size() - i);
+          arith.probable_prime_batch(&values[i], prime, len);
+          for (std::size_t k = 0; k < len; ++k) {
+            if (prime[k]) emit(values[i + k]);
+          }
+        }
+        return;
+      }
+    }
+    for (const value_type& c : values) {
+      if (arith.probable_prime(c)) emit(c);
+    }
+  }
+
+  // Survivants de la fenêtre testés par lots de BATCH (probable_prime_batch),
+  // émis dans l'ordre (décroissant si down) ; s'arrête après `wanted` premiers. Un lot
+  // ne dépasse pas 4 candidats par premier restant à trouver (un seul premier cherché :
+  // une passe de `lanes` voies, pas 64 tests dont la plupart seraient inutiles).
+  template <class Emit>
+  static std::size_t test_window_batched(Arith& arith, const value_type& n, std::size_t len,
+                                         const char* composite, std::size_t wanted, Emit& emit, bool down = false) {
+    constexpr std::size_t BATCH = 64;
+    value_type group[BATCH];
+    bool prime[BATCH];
+    std::size_t filled = 0;
+    std::size_t found = 0;
+    auto flush = [&]() {
+      arith.probable_prime_batch(group, prime, filled);
+      for (std::size_t k = 0; k < filled && found < wanted; ++k) {
+        if (prime[k]) { emit(group[k]); ++found; }
+      }
+      filled = 0;
+    };
+    for (std::size_t i = 0; i < len && found < wanted; ++i) {
+      const std::size_t j = down ? len - 1 - i : i;
+      if (composite[j]) continue;
+      group[filled++] = n + value_type(2 * j);
+      if (filled == std::min(BATCH, std::max<std::size_t>(batch_lanes<Arith>::value, 4 * (wanted - found)))) flush();
+    }
+    if (filled > 0 && found < wanted) flush();
+    return found;
+  }
+
+  // Vagues de fenêtres consécutives réparties par parallel_for (une fenêtre par
+  // élément, découpage et vol laissés au pool) ; chaque thread teste avec sa propre
+  // copie de la politique (fork), les premiers de chaque fenêtre sont émis dans l'ordre.
+  // bottom != 0 : parcours décroissant depuis n (impair), jusqu'au candidat bottom.
+  template <class Emit>
+  std::size_t generate_parallel(value_type n, std::size_t count, Emit& emit, WorkStealingPool& pool,
+                                value_type bottom = 0) {
+    const bool down = bottom != 0;
+    const std::size_t threads = pool.size() + 1;
+    std::vector<Arith> forks;
+    for (unsigned t = 0; t <= pool.size(); ++t) forks.push_back(arith_.fork(t));
+    std::vector<std::vector<char>> scratch(pool.size() + 1, std::vector<char>(SIEVE_WINDOW));
+
+    std::size_t found = 0, windows_done = 0, primes_seen = 0;
+    bool last = false;
+    while (found < count && !last) {
+      // taille de la vague : ce que la densité observée laisse prévoir pour finir,
+      // entre 1 et 4 fenêtres par thread (pas de vague surdimensionnée en fin de course)
+      std::size_t wave = threads;
+      if (primes_seen > 0) {
+        const std::size_t needed = ((count - found) * windows_done + primes_seen - 1) / primes_seen;
+        wave = std::min(4 * threads, std::max(threads, needed));
+      }
+      // bases et longueurs des fenêtres de la vague
+      std::vector<value_type> base;
+      std::vector<std::size_t> len;
+      while (base.size() < wave && !last) {
+        if (down) {
+          len.push_back(window_below(n, bottom));
+          base.push_back(n - value_type(2 * (len.back() - 1)));
+          last = base.back() == bottom;
+          if (!last) n = base.back() - 2;
+        }
+        else {
+          base.push_back(n);
+          len.push_back(window_length(n, last));
+          if (!last) n += value_type(2 * len.back());
+        }
+      }
+      std::vector<std::vector<value_type>> primes(base.size());
+      pool.parallel_for(0, base.size(), 1, [&](std::size_t lo, std::size_t hi) {
+        const unsigned t = pool.current_index();
+        for (std::size_t w = lo; w < hi; ++w) {
+          auto collect = [&primes, w](const value_type& p) { primes[w].push_back(p); };
+          // au-delà de count - found premiers, une fenêtre n'aurait rien à émettre
+          test_window(forks[t], base[w], len[w], scratch[t].data(), count - found, collect, down);
+        }
+      });
+      for (std::size_t w = 0; w < primes.size(); ++w) {
+        primes_seen += primes[w].size();
+        ++windows_done;
+        for (std::size_t k = 0; k < primes[w].size() && found < count; ++k) {
+          emit(primes[w][k]);
+          ++found;
+        }
+      }
+    }
+    return found;
+  }
+
+  static constexpr std::uint32_t MAX_SMALL = SMALL_PRIMES.prime[SMALL_PRIMES.size - 1];
+  static constexpr std::uint64_t SIEVE_COMPLETE = std::uint64_t(MAX_SMALL) * MAX_SMALL;
+
+  Arith arith_;
+};
+
+// Réglages du front-end.
+struct GenerateOptions {
+  u64 seed = std::random_device{}();  // bases aléatoires au-delà de 2^81
+  Mr64Mode mr64 = Mr64Mode::Bases7;   // test des candidats 64 bits
+  unsigned threads = 1;               // > 1 : pool à vol de tâches (0 : un par cœur)
+  bool pipeline = false;              // avec threads != 1 : pipeline crible -> test -> sortie
+  unsigned round_threads = 1;         // threads par candidat (tours de Miller-Rabin) ...
+  unsigned round_threads_bits = 16384; // ... à partir de cette taille en bits
+  bool gerbicz = false;               // contrôle de Gerbicz du tour en base 2 (candidats NTT)
+  bool down = false;                  // premiers <= start, décroissants (sans pipeline)
+};
+
+// Politique multiprécision réglée selon opt (tours répartis, contrôle de Gerbicz).
+template <class Arith>
+inline Arith configured(Arith arith, const GenerateOptions& opt) {
+  arith.set_round_threads(opt.round_threads, opt.round_threads_bits);
+  arith.set_gerbicz(opt.gerbicz);
+  return arith;
+}
+
+// Front-end : enchaîne les moteurs du plus étroit au plus large, chaque plage de
+// valeurs étant traitée par l'arithmétique la plus rapide qui la contient
+// (u32 -> u64 -> u128 -> 256 -> 512 -> 1024 bits -> cpp_int). Émet toujours exactement
+// `count` premiers, dans l'ordre croissant ; emit reçoit une valeur de chaque largeur
+// (lambda générique). shared : pool déjà lancé, utilisé à la place d'un pool créé pour
+// l'appel quand opt.threads != 1 (mode serveur).
+// opt.down : les premiers <= start, dans l'ordre décroissant, du plus large au plus
+// étroit ; s'arrête à 2, si bien que le nombre émis (renvoyé) peut être < count.
+template <class Emit>
+inline std::size_t generate_primes_hybrid(const cpp_int& start, std::size_t count, Emit&& emit,
+                                          const GenerateOptions& opt = GenerateOptions(),
+                                          WorkStealingPool* shared = nullptr) {
+  const u64 seed = opt.seed;
+  const bool pipelined = opt.threads != 1 && opt.pipeline && !opt.down;
+  std::unique_ptr<WorkStealingPool> owned;
+  if (opt.threads != 1 && !pipelined && shared == nullptr) owned.reset(new WorkStealingPool(opt.threads));
+  WorkStealingPool* pool = shared != nullptr ? shared : owned.get();
+  cpp_int from = start < 0 && !opt.down ? cpp_int(0) : start;
+  std::size_t left = count;
+
+  // Moteur suivant si `from` tient dans son type ; sinon on passe directement au suivant.
+  // make() ne construit le moteur (et ses générateurs) que si sa plage est atteinte.
+  auto stage = [&](auto make) {
+    using Engine = decltype(make());
+    using T = typename Engine::value_type;
+    if (left == 0) return;
+    cpp_int limit;
+    if constexpr (Engine::bounded) {
+      limit = cpp_int(std::numeric_limits<T>::max());
+      if (from > limit) return;
+    }
+    Engine engine = make();
+    if (pipelined) {
+      left -= engine.generate_pipelined(static_cast<T>(from), left, emit, opt.threads);
+    }
+    else {
+      left -= engine.generate(static_cast<T>(from), left, emit, pool);
+    }
+    from = limit + 1;
+  };
+
+  // Parcours décroissant : le moteur traite [2^lowest_bits, from] puis passe au plus étroit.
+  auto stage_down = [&](auto make, unsigned lowest_bits) {
+    using T = typename decltype(make())::value_type;
+    const cpp_int lowest = lowest_bits == 0 ? cpp_int(0) : cpp_int(1) << lowest_bits;
+    if (left == 0 || from < lowest) return;
+    auto engine = make();
+    left -= engine.generate_down(static_cast<T>(from), left, emit, pool, static_cast<T>(lowest));
+    from = lowest - 1;
+  };
+
+  auto wide = [&opt](auto arith) { return PrimeEngine<decltype(arith)>(configured(arith, opt)); };
+
+  if (opt.down) {
+    stage_down([&] { return wide(BigArith(32, seed)); }, 1024);
+    stage_down([&] { return wide(FixedArith<1024>(32, seed)); }, 512);
+    stage_down([&] { return wide(FixedArith<512>(32, seed)); }, 256);
+    stage_down([&] { return wide(FixedArith<256>(32, seed)); }, 128);
+    stage_down([&] { return wide(Arith128(32, seed)); }, 64);
+    stage_down([&] { return PrimeEngine<Arith64>(Arith64(opt.mr64)); }, 32);
+    stage_down([] { return PrimeEngine<Arith32>(); }, 0);
+    return count - left;
+  }
+  stage([] { return PrimeEngine<Arith32>(); });
+  stage([&] { return PrimeEngine<Arith64>(Arith64(opt.mr64)); });
+  stage([&] { return wide(Arith128(32, seed)); });
+  stage([&] { return wide(FixedArith<256>(32, seed)); });
+  stage([&] { return wide(FixedArith<512>(32, seed)); });
+  stage([&] { return wide(FixedArith<1024>(32, seed)); });
+  stage([&] { return wide(BigArith(32, seed)); });
+  return count - left;
+}
+
+// Test d'un entier quelconque par le moteur de la plus petite largeur qui le contient
+// (mêmes politiques que generate_primes_hybrid) ; les moteurs et leurs générateurs
+// sont gardés d'un appel à l'autre.
+class PrimeTester {
+public:
+  explicit PrimeTester(const GenerateOptions& opt = GenerateOptions())
+    : e64_(Arith64(opt.mr64)), e128_(configured(Arith128(32, opt.seed), opt)),
+      e256_(configured(FixedArith<256>(32, opt.seed), opt)), e512_(configured(FixedArith<512>(32, opt.seed), opt)),
+      e1024_(configured(FixedArith<1024>(32, opt.seed), opt)), big_(configured(BigArith(32, opt.seed), opt)) {}
+
+  bool is_prime(const cpp_int& n) {
+    if (n <= std::numeric_limits<u64>::max()) return n >= 0 && e64_.is_prime(static_cast<u64>(n));
+    const unsigned bits = static_cast<unsigned>(boost::multiprecision::msb(n)) + 1;
+    if (bits <= 128) return e128_.is_prime(static_cast<uint128_t>(n));
+    if (bits <= 256) return e256_.is_prime(static_cast<fixed_uint<256>>(n));
+    if (bits <= 512) return e512_.is_prime(static_cast<fixed_uint<512>>(n));
+    if (bits <= 1024) return e1024_.is_prime(static_cast<fixed_uint<1024>>(n));
+    return big_.is_prime(n);
+  }
+
+private:
+  PrimeEngine<Arith64> e64_;
+  PrimeEngine<Arith128> e128_;
+  PrimeEngine<FixedArith<256>> e256_;
+  PrimeEngine<FixedArith<512>> e512_;
+  PrimeEngine<FixedArith<1024>> e1024_;
+  PrimeEngine<BigArith> big_;
+};
+
+} // namespace primes
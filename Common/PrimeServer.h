@@ -0,0 +1,391 @@
+// PrimeServer.h
+// Mode serveur (--serve SOCKET) : un processus reste lancé et répond sur une socket Unix
+// locale, avec ses moteurs (PrimeTester), son pool de threads et ses puissances de 10
+// déjà prêts, au lieu d'un processus par requête. Protocole texte, une ligne par requête
+// et une ligne par réponse, dans l'ordre ; un client peut envoyer plusieurs requêtes
+// sans attendre les réponses (pipeline), elles repartent groupées.
+//
+//   is_prime N           -> 1 ou 0
+//   next_prime N         -> plus petit premier > N
+//   prev_prime N         -> plus grand premier < N, ou "none"
+//   primes START COUNT   -> les COUNT premiers >= START, séparés par des espaces
+//   stats                -> nombre de requêtes et percentiles de latence par commande
+//   shutdown             -> "bye" ; le serveur s'arrête quand les clients sont partis
+//
+// Entiers en décimal ou en hexadécimal (0x...). Erreur : "ERR message".
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "Decimal.h"
+#include "PrimeEngine.h"
+#include "WorkStealingPool.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace primes {
+
+// Latences (µs) des LATENCY_WINDOW dernières requêtes d'une commande.
+class LatencyStats {
+public:
+  static constexpr std::size_t LATENCY_WINDOW = 1u << 16;
+
+  void add(double us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() < LATENCY_WINDOW) samples_.push_back(us);
+    else samples_[count_ % LATENCY_WINDOW] = us;
+    ++count_;
+  }
+
+  // "n=… p50=…us p90=… p99=… p99.9=… max=…"
+  std::string summary() const {
+    std::vector<double> sorted;
+    std::uint64_t count;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sorted = samples_;
+      count = count_;
+    }
+    std::ostringstream out;
+    out << "n=" << count;
+    if (sorted.empty()) return out.str();
+    std::sort(sorted.begin(), sorted.end());
+    auto at = [&sorted](double q) { return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * sorted.size()))]; };
+    out << std::fixed;
+    out.precision(1);
+    out << " p50=" << at(0.5) << "us p90=" << at(0.9) << "us p99=" << at(0.99) << "us p99.9=" << at(0.999)
+        << "us max=" << sorted.back() << "us";
+    return out.str();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<double> samples_;
+  std::uint64_t count_ = 0;
+};
+
+// État partagé par les connexions : options, pool de threads, statistiques.
+class PrimeService {
+public:
+  // Au-delà, primes(start, count) est refusé (une réponse tient sur une ligne).
+  static constexpr std::size_t MAX_COUNT = 1u << 20;
+
+  enum Command { IS_PRIME, NEXT_PRIME, PREV_PRIME, PRIMES, COMMANDS };
+
+  explicit PrimeService(const GenerateOptions& opt) : opt_(opt) {
+    if (opt_.threads != 1) pool_.reset(new WorkStealingPool(opt_.threads));
+    opt_.pipeline = false;
+  }
+
+  // Ce qu'une connexion garde d'une requête à l'autre : le testeur de is_prime et les
+  // moteurs de next_prime, prev_prime et primes (une largeur chacun), déjà amorcés.
+  struct Session {
+    explicit Session(const GenerateOptions& opt)
+      : options(opt), tester(opt), e64(Arith64(opt.mr64)), e128(configured(Arith128(32, opt.seed), opt)),
+        e256(configured(FixedArith<256>(32, opt.seed), opt)), e512(configured(FixedArith<512>(32, opt.seed), opt)),
+        e1024(configured(FixedArith<1024>(32, opt.seed), opt)), big(configured(BigArith(32, opt.seed), opt)) {}
+    GenerateOptions options; // graine propre à la connexion (session())
+    PrimeTester tester;
+    PrimeEngine<Arith32> e32;
+    PrimeEngine<Arith64> e64;
+    PrimeEngine<Arith128> e128;
+    PrimeEngine<FixedArith<256>> e256;
+    PrimeEngine<FixedArith<512>> e512;
+    PrimeEngine<FixedArith<1024>> e1024;
+    PrimeEngine<BigArith> big;
+    DecimalWriter writer;
+  };
+
+  Session session(unsigned salt) const {
+    GenerateOptions opt = opt_;
+    opt.seed ^= u64(salt) * 0x9E3779B97F4A7C15ull;
+    return Session(opt);
+  }
+
+  bool stopping() const { return stop_.load(); }
+
+  // Traite une ligne de requête, ajoute la réponse (terminée par '\n') à out.
+  void handle(std::string_view line, Session& s, std::string& out) {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::string_view> words;
+    for (std::size_t i = 0; i < line.size();) {
+      while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i;
+      std::size_t j = i;
+      while (j < line.size() && line[j] != ' ' && line[j] != '\t' && line[j] != '\r') ++j;
+      if (j > i) words.push_back(line.substr(i, j - i));
+      i = j;
+    }
+    int command = COMMANDS;
+    try {
+      if (words.empty()) throw std::invalid_argument("requête vide");
+      const std::string_view name = words[0];
+      auto number = [&words](std::size_t i) {
+        if (i >= words.size()) throw std::invalid_argument("argument manquant");
+        return parse_integer(words[i].data(), words[i].size());
+      };
+      if (name == "is_prime") {
+        command = IS_PRIME;
+        out += s.tester.is_prime(number(1)) ? '1' : '0';
+      }
+      else if (name == "next_prime" || name == "prev_prime") {
+        // même crible par fenêtres que primes, vers le haut ou (prev_prime) vers le bas
+        const bool down = name == "prev_prime";
+        command = down ? PREV_PRIME : NEXT_PRIME;
+        bool found = false;
+        auto emit = [&](const auto& p) {
+          append(s, cpp_int(p), out);
+          found = true;
+        };
+        generate(s, down ? number(1) - 1 : number(1) + 1, 1, emit, down);
+        if (!found) out += "none";
+      }
+      else if (name == "primes") {
+        command = PRIMES;
+        const cpp_int count = number(2);
+        if (count < 0 || count > MAX_COUNT) throw std::invalid_argument("COUNT entre 0 et " + std::to_string(MAX_COUNT));
+        std::size_t emitted = 0;
+        auto emit = [&](const auto& p) {
+          if (emitted++ != 0) out += ' ';
+          append(s, cpp_int(p), out);
+        };
+        generate(s, number(1), static_cast<std::size_t>(count), emit, false);
+      }
+      else if (name == "stats") {
+        static const char* const names[COMMANDS] = { "is_prime", "next_prime", "prev_prime", "primes" };
+        for (int c = 0; c < COMMANDS; ++c) {
+          if (c != 0) out += " | ";
+          out += names[c];
+          out += ' ';
+          out += latency_[c].summary();
+        }
+      }
+      else if (name == "shutdown") {
+        stop_.store(true);
+        out += "bye";
+      }
+      else {
+        throw std::invalid_argument("commande inconnue : " + std::string(name));
+      }
+    }
+    catch (const std::exception& e) {
+      out += "ERR ";
+      out += e.what();
+    }
+    out += '\n';
+    if (command != COMMANDS) {
+      latency_[command].add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+  }
+
+private:
+  // Premiers >= start (ou <= start si down) par le moteur de la session de la largeur
+  // de start ; generate_primes_hybrid ne prend le relais que si la suite sort de cette
+  // largeur. Le pool n'accepte qu'un appelant à la fois.
+  template <class Emit>
+  void generate(Session& s, const cpp_int& start, std::size_t count, Emit& emit, bool down) {
+    if (count == 0 || (down && start < 2)) return;
+    std::unique_lock<std::mutex> lock(pool_mutex_, std::defer_lock);
+    if (pool_) lock.lock();
+    WorkStealingPool* pool = pool_.get();
+    const cpp_int from = start < 0 ? cpp_int(0) : start;
+    std::size_t found = 0;
+    cpp_int rest = -1; // départ du relais, -1 : rien au-delà de la largeur
+    // lowest_bits : borne basse 2^lowest_bits de la largeur (parcours décroissant)
+    auto run = [&](auto& engine, unsigned lowest_bits) {
+      using T = typename std::decay_t<decltype(engine)>::value_type;
+      if (down) {
+        const T lowest = lowest_bits == 0 ? T(0) : T(1) << lowest_bits;
+        found = engine.generate_down(static_cast<T>(from), count, emit, pool, lowest);
+        if (lowest_bits != 0) rest = cpp_int(lowest) - 1;
+      }
+      else {
+        found = engine.generate(static_cast<T>(from), count, emit, pool);
+        if constexpr (std::decay_t<decltype(engine)>::bounded) rest = cpp_int(std::numeric_limits<T>::max()) + 1;
+      }
+    };
+    if (from <= std::numeric_limits<u32>::max()) run(s.e32, 0);
+    else if (from <= std::numeric_limits<u64>::max()) run(s.e64, 32);
+    else {
+      const unsigned bits = static_cast<unsigned>(boost::multiprecision::msb(from)) + 1;
+      if (bits <= 128) run(s.e128, 64);
+      else if (bits <= 256) run(s.e256, 128);
+      else if (bits <= 512) run(s.e512, 256);
+      else if (bits <= 1024) run(s.e1024, 512);
+      else run(s.big, 1024);
+    }
+    if (found < count && rest >= 0) {
+      GenerateOptions opt = s.options;
+      opt.down = down;
+      generate_primes_hybrid(rest, count - found, emit, opt, pool);
+    }
+  }
+
+  static void append(Session& s, const cpp_int& x, std::string& out) {
+    const std::string_view text = s.writer.format(x);
+    out.append(text.data(), text.size());
+  }
+
+  GenerateOptions opt_;
+  std::unique_ptr<WorkStealingPool> pool_;
+  std::mutex pool_mutex_;
+  std::atomic<bool> stop_{ false };
+  LatencyStats latency_[COMMANDS];
+};
+
+#ifndef _WIN32
+
+namespace server {
+
+// Ligne de requête la plus longue acceptée (un START de plusieurs millions de chiffres
+// passe) ; au-delà, le client reçoit une erreur et la connexion est fermée.
+constexpr std::size_t MAX_LINE = 4u << 20;
+
+inline bool send_all(int fd, const char* data, std::size_t len) {
+  while (len > 0) {
+    const ssize_t n = ::send(fd, data, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    len -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Lit les requêtes d'un client ; les réponses à tout ce qui est arrivé d'un coup
+// partent en un seul envoi. Après shutdown, réveille accept sur `listener`. Une ligne
+// de plus de MAX_LINE octets sans '\n' met fin à la connexion.
+inline void serve_client(int fd, int listener, PrimeService& service, unsigned salt) {
+  PrimeService::Session session = service.session(salt);
+  std::string input, output;
+  char chunk[1 << 16];
+  for (;;) {
+    const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    input.append(chunk, static_cast<std::size_t>(n));
+    std::size_t begin = 0;
+    for (std::size_t end; (end = input.find('\n', begin)) != std::string::npos; begin = end + 1) {
+      service.handle(std::string_view(input).substr(begin, end - begin), session, output);
+    }
+    input.erase(0, begin);
+    const bool too_long = input.size() > MAX_LINE;
+    if (too_long) output += "ERR ligne trop longue\n";
+    if (!output.empty() && !send_all(fd, output.data(), output.size())) break;
+    if (too_long) break;
+    output.clear();
+    if (service.stopping()) ::shutdown(listener, SHUT_RDWR);
+  }
+  ::close(fd);
+}
+
+} // namespace server
+
+// Écoute sur la socket Unix `path` jusqu'à une requête shutdown ; lève
+// std::runtime_error si la socket ne peut être créée ou si accept échoue durablement
+// (les erreurs passagères sont signalées sur stderr et l'attente reprend). Une socket laissée à `path` par
+// un serveur précédent est remplacée ; tout autre fichier est laissé en place (erreur).
+inline void serve(const std::string& path, const GenerateOptions& opt) {
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("chemin de socket trop long : " + path);
+  addr.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), addr.sun_path);
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) throw std::runtime_error("création de socket impossible");
+  struct stat existing;
+  if (::lstat(path.c_str(), &existing) == 0) {
+    if (!S_ISSOCK(existing.st_mode)) {
+      ::close(listener);
+      throw std::runtime_error(path + " n'est pas une socket");
+    }
+    ::unlink(path.c_str());
+  }
+  struct stat created;
+  if (::bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 64) != 0 ||
+      ::lstat(path.c_str(), &created) != 0) {
+    ::close(listener);
+    throw std::runtime_error("écoute impossible sur " + path);
+  }
+
+  PrimeService service(opt);
+  // un thread par client ; ceux qui ont fini sont rejoints à chaque nouvelle connexion
+  struct Client {
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> done;
+  };
+  std::vector<Client> clients;
+  unsigned salt = 0;
+  std::string failure;
+  while (!service.stopping()) {
+    for (std::size_t i = 0; i < clients.size();) {
+      if (clients[i].done->load()) {
+        clients[i].thread.join();
+        clients[i] = std::move(clients.back());
+        clients.pop_back();
+      }
+      else ++i;
+    }
+    const int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      const int error = errno;
+      if (service.stopping()) break;
+      if (error == EINTR || error == ECONNABORTED || error == EPROTO) continue;
+      // descripteurs ou mémoire épuisés : passager, on réessaie après une pause
+      if (error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM) {
+        std::cerr << "accept : " << std::strerror(error) << ", nouvel essai\n";
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        continue;
+      }
+      failure = std::strerror(error);
+      break;
+    }
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    clients.push_back(Client{ std::thread([fd, listener, &service, done, s = ++salt] {
+      server::serve_client(fd, listener, service, s);
+      done->store(true);
+    }), done });
+  }
+  ::close(listener);
+  // seulement la socket créée ici, si un autre processus ne l'a pas remplacée entre-temps
+  struct stat current;
+  if (::lstat(path.c_str(), &current) == 0 && current.st_dev == created.st_dev && current.st_ino == created.st_ino) {
+    ::unlink(path.c_str());
+  }
+  for (Client& c : clients) c.thread.join();
+  if (!failure.empty()) throw std::runtime_error("accept impossible sur " + path + " : " + failure);
+}
+
+#else
+
+inline void serve(const std::string&, const GenerateOptions&) {
+  throw std::runtime_error("mode serveur : sockets Unix non prises en charge sous Windows");
+}
+
+#endif
+
+} // namespace primes
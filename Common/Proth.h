@@ -0,0 +1,228 @@
+// Proth.h
+// Recherche de premiers de Proth N = k·2^n + 1 (k impair, k < 2^n) :
+//  - crible sur k : p divise k·2^n + c exactement quand k = -c·2^-n (mod p), une seule
+//    racine par premier, calculée une fois pour tout l'intervalle de k (KSieve) ;
+//  - réduction modulo N par décalages (K2nModulus) : k·2^n = -1 (mod N) ;
+//  - théorème de Proth : N est premier si et seulement si a^((N-1)/2) = -1 (mod N) pour
+//    un a tel que (a / N) = -1, soit une seule exponentiation, et une preuve.
+// Les carrés passent par ntt::mul (NTT au-delà de ntt_threshold_bits()).
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Arithmetic.h"
+#include "Ntt.h"
+#include "WorkStealingPool.h"
+
+#ifndef KSIEVE_LIMIT
+#define KSIEVE_LIMIT (1u << 20)
+#endif
+
+namespace primes {
+
+// Nombre de k impairs par fenêtre du crible.
+constexpr std::size_t KSIEVE_WINDOW = 1u << 16;
+
+// Premiers impairs < limit (crible d'Ératosthène).
+inline std::vector<u32> odd_primes_below(u32 limit) {
+  std::vector<char> composite(limit, 0);
+  std::vector<u32> out;
+  for (u32 i = 3; i < limit; i += 2) {
+    if (composite[i]) continue;
+    out.push_back(i);
+    for (u64 j = u64(i) * i; j < limit; j += 2 * i) composite[j] = 1;
+  }
+  return out;
+}
+
+// Crible des k impairs tels que k·2^n + c (c = +1 ou -1) n'a pas de facteur premier
+// impair < limit (en dehors du nombre lui-même quand il est aussi petit).
+class KSieve {
+public:
+  KSieve(unsigned n, int c, u32 limit = KSIEVE_LIMIT) : n_(n), c_(c) {
+    for (u32 p : odd_primes_below(limit)) {
+      // k = -c · (2^n)^-1 (mod p), l'inverse par le petit théorème de Fermat
+      const u64 inv = pow_mod(pow_mod(2, n, p), p - 2, p);
+      primes_.push_back(p);
+      root_.push_back(static_cast<u32>(c > 0 ? (p - inv) % p : inv));
+    }
+  }
+
+  // composite[j] pour k = k0 + 2j, j < len (k0 impair)
+  void sieve(u64 k0, std::size_t len, char* composite) const {
+    std::fill(composite, composite + len, 0);
+    for (std::size_t i = 0; i < primes_.size(); ++i) {
+      const u64 p = primes_[i];
+      // k0 + 2j = root (mod p) : j = (root - k0) · 2^-1 (mod p)
+      u64 j = (root_[i] + p - k0 % p) % p * ((p + 1) / 2) % p;
+      for (; j < len; j += p) {
+        if (!is_self(k0 + 2 * j, p)) composite[j] = 1;
+      }
+    }
+  }
+
+private:
+  // k·2^n + c == p ?
+  bool is_self(u64 k, u64 p) const {
+    return n_ < 32 && k <= ((p + 1) >> n_) && (k << n_) + c_ == p;
+  }
+
+  unsigned n_;
+  int c_;
+  std::vector<u32> primes_, root_;
+};
+
+// Crible sur n à k fixé : p divise k·2^n + c quand 2^n = -c·k^-1 (mod p), ce qui se
+// répète avec la période de 2 modulo p ; on marche de n en n jusqu'aux deux premières
+// occurrences, puis on avance d'une période.
+class NSieve {
+public:
+  NSieve(u64 k, int c, u32 limit = KSIEVE_LIMIT) : k_(k), c_(c), primes_(odd_primes_below(limit)) {}
+
+  // composite[j] pour n = n0 + j, j < len
+  void sieve(unsigned n0, std::size_t len, char* composite) const {
+    std::fill(composite, composite + len, 0);
+    for (u64 p : primes_) {
+      const u64 km = k_ % p;
+      if (km == 0) continue;
+      const u64 target = c_ > 0 ? p - pow_mod(km, p - 2, p) : pow_mod(km, p - 2, p);
+      u64 x = pow_mod(2, n0, p);
+      std::size_t first = len;
+      for (std::size_t j = 0; j < len; ++j, x = 2 * x % p) {
+        if (x != target) continue;
+        if (first == len) { first = j; continue; }
+        for (std::size_t i = first; i < len; i += j - first) mark(n0, i, p, composite);
+        first = len + 1;
+        break;
+      }
+      if (first < len) mark(n0, first, p, composite);
+    }
+  }
+
+private:
+  void mark(unsigned n0, std::size_t j, u64 p, char* composite) const {
+    const u64 n = n0 + j;
+    if (!(n < 32 && k_ <= ((p + 1) >> n) && (k_ << n) + c_ == p)) composite[j] = 1;
+  }
+
+  u64 k_;
+  int c_;
+  std::vector<u32> primes_;
+};
+
+// Arithmétique modulo N = k·2^n + c (c = +1 ou -1) : pour x = h·2^n + l et
+// h = q·k + s, x = s·2^n + l - c·q (mod N), avec une division de h par le seul
+// mot k ; pour k = 1 (2^n - 1, Mersenne), décalages et additions seulement.
+class K2nModulus {
+public:
+  K2nModulus(u64 k, unsigned n, int c = +1)
+    : k_(k), n_(n), c_(c), N_((cpp_int(k) << n) + c), mask_((cpp_int(1) << n) - 1) {}
+
+  const cpp_int& value() const { return N_; }
+
+  // x mod N, pour 0 <= x < N^2
+  cpp_int reduce(const cpp_int& x) const {
+    if (x < N_) return x;
+    cpp_int q = x >> n_, s = 0;
+    if (k_ != 1) boost::multiprecision::divide_qr(cpp_int(q), cpp_int(k_), q, s);
+    cpp_int r = (s << n_) + (x & mask_);
+    if (c_ > 0) {
+      r -= q;
+      while (r < 0) r += N_;
+    }
+    else {
+      r += q;
+      while (r >= N_) r -= N_;
+    }
+    return r;
+  }
+
+  cpp_int sqr(const cpp_int& a) const { return reduce(ntt::mul(a, a)); }
+  cpp_int mul(const cpp_int& a, const cpp_int& b) const { return reduce(ntt::mul(a, b)); }
+
+  // a^e mod N pour un exposant d'un mot
+  cpp_int pow(const cpp_int& a, u64 e) const {
+    if (e == 0) return 1;
+    int bit = 63;
+    while (((e >> bit) & 1) == 0) --bit;
+    cpp_int r = reduce(a);
+    while (bit-- > 0) {
+      r = sqr(r);
+      if ((e >> bit) & 1) r = mul(r, a);
+    }
+    return r;
+  }
+
+private:
+  u64 k_;
+  unsigned n_;
+  int c_;
+  cpp_int N_, mask_;
+};
+
+// Théorème de Proth pour N = k·2^n + 1, k impair < 2^n, n >= 2 : résultat prouvé.
+// Si aucun petit premier n'est non-résidu (N carré, ou malchance), repli sur Miller-Rabin.
+inline bool proth_prime(u64 k, unsigned n) {
+  const K2nModulus mod(k, n, +1);
+  const cpp_int& N = mod.value();
+  // N = 1 (mod 4) : par réciprocité, (p / N) = (N mod p / p)
+  u32 a = 0;
+  for (std::size_t i = 1; i < SMALL_PRIMES.size && a == 0; ++i) {
+    const u32 p = SMALL_PRIMES.prime[i];
+    const u64 r = static_cast<u64>(N % p);
+    if (r == 0) return N == p;
+    if (jacobi(r, p) == -1) a = p;
+  }
+  if (a == 0) return BigArith().probable_prime(N);
+
+  // a^((N-1)/2) = (a^k)^(2^(n-1))
+  cpp_int x = mod.pow(a, k);
+  for (unsigned i = 1; i < n; ++i) x = mod.sqr(x);
+  return x == N - 1;
+}
+
+// Teste en parallèle (avec un pool) les valeurs de survivors, prime[i] = test(survivors[i]).
+template <class Test>
+inline std::vector<char> test_survivors(const std::vector<u64>& survivors, Test&& test, WorkStealingPool* pool) {
+  std::vector<char> prime(survivors.size(), 0);
+  if (pool != nullptr) {
+    pool->parallel_for(0, survivors.size(), 1, [&](std::size_t lo, std::size_t hi) {
+      for (std::size_t i = lo; i < hi; ++i) prime[i] = test(survivors[i]);
+    });
+  }
+  else {
+    for (std::size_t i = 0; i < survivors.size(); ++i) prime[i] = test(survivors[i]);
+  }
+  return prime;
+}
+
+// Émet dans l'ordre les k impairs de [k_lo, k_hi] pour lesquels k·2^n + 1 est premier
+// (k_hi < 2^n) ; renvoie leur nombre. Avec un pool, les survivants de chaque fenêtre
+// du crible sont testés en parallèle.
+template <class Emit>
+inline std::size_t proth_search(u64 k_lo, u64 k_hi, unsigned n, Emit&& emit, WorkStealingPool* pool = nullptr) {
+  const KSieve ksieve(n, +1);
+  std::vector<char> composite(KSIEVE_WINDOW);
+  std::size_t found = 0;
+  for (u64 k0 = k_lo | 1; k0 <= k_hi;) {
+    const std::size_t len = static_cast<std::size_t>(std::min<u64>(KSIEVE_WINDOW - 1, (k_hi - k0) / 2) + 1);
+    ksieve.sieve(k0, len, composite.data());
+    std::vector<u64> survivors;
+    for (std::size_t j = 0; j < len; ++j) {
+      if (!composite[j]) survivors.push_back(k0 + 2 * j);
+    }
+    const std::vector<char> prime = test_survivors(survivors, [n](u64 k) { return proth_prime(k, n); }, pool);
+    for (std::size_t i = 0; i < survivors.size(); ++i) {
+      if (prime[i]) { emit(survivors[i]); ++found; }
+    }
+    if (k_hi - k0 < 2 * u64(len)) break;
+    k0 += 2 * u64(len);
+  }
+  return found;
+}
+
+} // namespace primes
@@ -0,0 +1,139 @@
+// RawFormat.h
+// Sorties sans conversion décimale, pour les consommateurs qui relisent en binaire :
+//  - hex   : une ligne par premier, chiffres hexadécimaux minuscules sans préfixe
+//            (chaque mot de 64 bits donne 16 chiffres, aucune division) ;
+//  - limbs : par premier, nombre de mots (8 octets) puis les mots de 64 bits,
+//            poids faible d'abord, tout en petit-boutiste.
+// Les deux passent par OutputBuffer, qui n'écrit que par blocs de 1 Mo ; pour un
+// cpp_int sur machine petit-boutiste, les mots sont copiés tels quels (memcpy).
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/predef/other/endian.h>
+
+namespace primes {
+
+using boost::multiprecision::cpp_int;
+
+// Tampon d'écriture de grande taille devant un std::ostream.
+class OutputBuffer {
+public:
+  explicit OutputBuffer(std::ostream& out, std::size_t capacity = 1u << 20) : out_(out) {
+    buffer_.reserve(capacity);
+  }
+
+  ~OutputBuffer() { flush(); }
+
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  void write(const void* data, std::size_t len) {
+    if (buffer_.size() + len > buffer_.capacity()) flush();
+    if (len > buffer_.capacity()) {
+      out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+      return;
+    }
+    const char* p = static_cast<const char*>(data);
+    buffer_.insert(buffer_.end(), p, p + len);
+  }
+
+  void put(char c) {
+    if (buffer_.size() == buffer_.capacity()) flush();
+    buffer_.push_back(c);
+  }
+
+  void flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+  }
+
+private:
+  std::ostream& out_;
+  std::vector<char> buffer_;
+};
+
+namespace raw {
+
+// Mots de 64 bits de x, poids faible d'abord (au moins un).
+template <class T>
+inline void limbs64(const T& x, std::vector<std::uint64_t>& out) {
+  out.clear();
+  if constexpr (std::is_integral<T>::value) {
+    out.push_back(static_cast<std::uint64_t>(x));
+  }
+  else {
+    if (x != 0) boost::multiprecision::export_bits(x, std::back_inserter(out), 64, false);
+    if (out.empty()) out.push_back(0);
+  }
+}
+
+} // namespace raw
+
+// Écrit les premiers en hexadécimal ou en mots de 64 bits dans un OutputBuffer.
+class RawWriter {
+public:
+  enum class Format { Hex, Limbs };
+
+  RawWriter(OutputBuffer& out, Format format) : out_(out), format_(format) {}
+
+  template <class T>
+  void add(const T& p) {
+    if constexpr (std::is_same<T, cpp_int>::value) {
+#if BOOST_ENDIAN_LITTLE_BYTE
+      if (format_ == Format::Limbs && sizeof(boost::multiprecision::limb_type) == 8) {
+        const std::uint64_t count = p.backend().size();
+        out_.write(&count, sizeof(count));
+        out_.write(p.backend().limbs(), count * 8);
+        return;
+      }
+#endif
+    }
+    raw::limbs64(p, limbs_);
+    if (format_ == Format::Limbs) put_limbs();
+    else put_hex();
+  }
+
+private:
+  void put_limbs() {
+    unsigned char bytes[8];
+    auto put_u64 = [&](std::uint64_t v) {
+      for (int i = 0; i < 8; ++i) bytes[i] = static_cast<unsigned char>(v >> (8 * i));
+      out_.write(bytes, 8);
+    };
+    put_u64(limbs_.size());
+    for (std::uint64_t w : limbs_) put_u64(w);
+  }
+
+  void put_hex() {
+    static const char digits[] = "0123456789abcdef";
+    char text[16];
+    const std::uint64_t top = limbs_.back();
+    int n = 0;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      if (n == 0 && shift > 0 && (top >> shift) == 0) continue;
+      text[n++] = digits[(top >> shift) & 15];
+    }
+    out_.write(text, n);
+    for (std::size_t i = limbs_.size() - 1; i-- > 0;) {
+      for (int k = 0; k < 16; ++k) text[k] = digits[(limbs_[i] >> (60 - 4 * k)) & 15];
+      out_.write(text, 16);
+    }
+    out_.put('\n');
+  }
+
+  OutputBuffer& out_;
+  Format format_;
+  std::vector<std::uint64_t> limbs_;
+};
+
+} // namespace primes
@@ -0,0 +1,91 @@
+// SmallPrimes.h
+// Table des N premiers nombres premiers, générée à la compilation par un crible
+// constexpr, avec ses tables compagnes :
+//  - inverse[i]    : p^-1 mod 2^64 (0 pour p = 2)
+//  - reciprocal[i] : floor((2^64 - 1) / p)
+//  - pow2_64[i]    : 2^64 mod p
+//
+// N se règle sans toucher au code : /D SMALL_PRIMES_COUNT=1000 (MSVC) ou
+// -DSMALL_PRIMES_COUNT=1000 (g++/clang). Par défaut : les 95 premiers < 500.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef SMALL_PRIMES_COUNT
+#define SMALL_PRIMES_COUNT 95
+#endif
+
+namespace primes {
+
+namespace detail {
+
+// Majorant du N-ième nombre premier : n (ln n + ln ln n) pour n >= 6 (Rosser).
+// ln est majoré par (floor(log2) + 1) * ln 2, ce qui ne fait qu'agrandir le crible.
+constexpr std::size_t ilog2_ceil(std::size_t n) {
+  std::size_t r = 0;
+  while (n) { n >>= 1; ++r; }
+  return r;
+}
+
+constexpr std::size_t nth_prime_bound(std::size_t n) {
+  if (n < 6) return 16;
+  const double ln2 = 0.6931471805599453;
+  const double ln_n = static_cast<double>(ilog2_ceil(n)) * ln2;
+  const double ln_ln_n = static_cast<double>(ilog2_ceil(ilog2_ceil(n))) * ln2;
+  return static_cast<std::size_t>(static_cast<double>(n) * (ln_n + ln_ln_n)) + 1;
+}
+
+// Inverse de p modulo 2^64 par Newton (p impair) : chaque pas double les bits justes.
+constexpr std::uint64_t inverse_mod_2_64(std::uint64_t p) {
+  std::uint64_t inv = p; // juste sur 3 bits
+  for (int i = 0; i < 5; ++i) inv *= 2 - p * inv;
+  return inv;
+}
+
+} // namespace detail
+
+template <std::size_t N>
+struct SmallPrimeTable {
+  static constexpr std::size_t size = N;
+  std::array<std::uint32_t, N> prime{};
+  std::array<std::uint64_t, N> inverse{};
+  std::array<std::uint64_t, N> reciprocal{};
+  std::array<std::uint32_t, N> pow2_64{};
+
+  // p_i divise n ? Pour p impair : n * p^-1 <= (2^64 - 1) / p, sans division.
+  constexpr bool divides(std::size_t i, std::uint64_t n) const {
+    if (i == 0) return (n & 1) == 0;
+    return n * inverse[i] <= reciprocal[i];
+  }
+};
+
+template <std::size_t N>
+constexpr SmallPrimeTable<N> make_small_prime_table() {
+  constexpr std::size_t bound = detail::nth_prime_bound(N);
+  std::array<bool, bound> composite{};
+  SmallPrimeTable<N> t{};
+  std::size_t count = 0;
+  for (std::size_t i = 2; i < bound && count < N; ++i) {
+    if (composite[i]) continue;
+    t.prime[count++] = static_cast<std::uint32_t>(i);
+    for (std::size_t j = i * i; j < bound; j += i) composite[j] = true;
+  }
+  for (std::size_t i = 0; i < N; ++i) {
+    const std::uint64_t p = t.prime[i];
+    t.inverse[i] = (p & 1) ? detail::inverse_mod_2_64(p) : 0;
+    t.reciprocal[i] = UINT64_MAX / p;
+    t.pow2_64[i] = static_cast<std::uint32_t>((UINT64_MAX % p + 1) % p);
+  }
+  return t;
+}
+
+inline constexpr auto SMALL_PRIMES = make_small_prime_table<SMALL_PRIMES_COUNT>();
+
+static_assert(SMALL_PRIMES.size >= 12, "SMALL_PRIMES_COUNT doit valoir au moins 12");
+static_assert(SMALL_PRIMES.prime[0] == 2 && SMALL_PRIMES.prime[SMALL_PRIMES.size - 1] != 0,
+              "crible constexpr incorrect");
+
+} // namespace primes
@@ -0,0 +1,141 @@
+// WorkStealingPool.h
+// Pool de threads à vol de tâches : une deque par thread. Le propriétaire empile et
+// dépile à l'arrière (LIFO, localité) ; un thread inactif vole à l'avant d'une autre
+// deque, là où se trouvent les plus gros morceaux. parallel_for découpe récursivement
+// son intervalle : un morceau chargé en premiers (tests coûteux) est recoupé et volé
+// pendant que les autres threads restent occupés.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace primes {
+
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  // threads = 0 : un thread par cœur
+  explicit WorkStealingPool(unsigned threads = 0) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    queues_ = std::vector<Queue>(threads + 1); // la dernière deque sert au thread appelant
+    for (unsigned i = 0; i < threads; ++i) {
+      workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) t.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // Nombre de threads de travail (le thread appelant aide en plus).
+  unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+  // Indice du thread courant dans [0, size()] : size() pour le thread appelant.
+  unsigned current_index() const { return index_ == NONE ? size() : index_; }
+
+  // body(lo, hi) sur tous les sous-intervalles de [begin, end) ; un morceau de plus de
+  // `grain` éléments se coupe en deux et expose une moitié au vol. Le thread appelant
+  // participe et la fonction revient quand tout est traité. Un seul appelant à la fois.
+  template <class Body>
+  void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Body&& body) {
+    if (begin >= end) return;
+    std::atomic<std::size_t> remaining(end - begin);
+    grain = std::max<std::size_t>(grain, 1);
+    std::function<void(std::size_t, std::size_t)> run = [&](std::size_t lo, std::size_t hi) {
+      while (hi - lo > grain) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        push([&run, mid, hi] { run(mid, hi); });
+        hi = mid;
+      }
+      body(lo, hi);
+      remaining -= hi - lo;
+    };
+    push([&run, begin, end] { run(begin, end); });
+    while (remaining.load() != 0) {
+      if (!run_one(size())) std::this_thread::yield();
+    }
+  }
+
+private:
+  static constexpr unsigned NONE = ~0u;
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(Task task) {
+    Queue& q = queues_[current_index()];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+    wake_.notify_one();
+  }
+
+  // Exécute une tâche : la sienne (arrière) sinon une volée (avant). Faux si rien à faire.
+  bool run_one(unsigned self) {
+    Task task;
+    {
+      Queue& q = queues_[self];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+    }
+    for (std::size_t k = 1; !task && k < queues_.size(); ++k) {
+      Queue& victim = queues_[(self + k) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+      }
+    }
+    if (!task) return false;
+    queued_.fetch_sub(1);
+    task();
+    return true;
+  }
+
+  void worker_loop(unsigned self) {
+    index_ = self;
+    while (true) {
+      if (run_one(self)) continue;
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      if (stop_) return;
+      wake_.wait_for(lock, std::chrono::milliseconds(10), [this] { return stop_ || queued_.load() > 0; });
+      if (stop_) return;
+    }
+  }
+
+  static inline thread_local unsigned index_ = NONE;
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> queued_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+} // namespace primes
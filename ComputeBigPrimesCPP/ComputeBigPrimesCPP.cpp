@@ -1,128 +1,358 @@
 // next_primes_from_n_fixed.cpp
-// Compile: g++ -O3 -std=c++17 next_primes_from_n_fixed.cpp -o next_primes_from_n
+// Compile: g++ -O3 -std=c++17 -pthread next_primes_from_n_fixed.cpp ../PrimesLib/Primes.cpp -o next_primes_from_n
+// Usage: ComputeBigPrimesCPP [start] [count] [--threads N [--pipeline]]
+//                            [--round-threads N [--round-threads-bits B]]
+//                            [--ntt-threshold B [--gerbicz]] [--bench]
+//                            [--format decimal|hex|gaps|limbs] [--output FICHIER]
+//                            [--flush full|line|MS] [--output-stats]
+//                            [--start-file FICHIER [--start-format auto|decimal|hex|limbs]]
+//                            [--checkpoint FICHIER [--checkpoint-every S] [--checkpoint-primes N]]
+//                            [--direction up|down]
+//          (--direction down : les `count` premiers <= start, décroissants, jusqu'à 2 au plus ;
+//           pas de --pipeline, de format gaps ni de point de reprise)
+//        ComputeBigPrimesCPP --resume FICHIER [--threads N ...]
+//        ComputeBigPrimesCPP --serve SOCKET [--threads N]
+//          (serveur sur socket Unix : is_prime, next_prime, prev_prime, primes, stats,
+//           shutdown, une ligne par requête, voir PrimeServer.h)
+//          (point de reprise réécrit toutes les S secondes (60) ou N premiers, Checkpoint.h ;
+//           --resume reprend la sortie là où le point de reprise l'a laissée et le met à jour)
+//          (sortie écrite par un thread dédié, AsyncOutput.h ; --flush : blocs pleins seulement,
+//           chaque ligne, ou après MS millisecondes sans écriture ; --output-stats : octets
+//           écrits et attentes du calcul sur stderr)
+//          (--start-file : départ lu dans un fichier projeté en mémoire, à la place de start ;
+//           auto : hexadécimal avec le préfixe 0x, décimal sinon ; limbs : format --format limbs)
+//        ComputeBigPrimesCPP --check [FICHIER] [--threads N] [--output FICHIER]
+//          (entiers décimaux ou 0x... lus dans FICHIER ou sur l'entrée standard ; une ligne
+//           1 ou 0 par entier, dans l'ordre de lecture, testés par lots, PrimeBatch.h)
+//          (génération et --check passent par PrimeContext, PrimesLib ; le projet Visual
+//           Studio référence PrimesLib)
+//        ComputeBigPrimesCPP --decode FICHIER [--from I] [count]
+//          (relit un fichier --format gaps, à partir du rang I)
+//        ComputeBigPrimesCPP --form proth --k-range A..B --n N [--threads N]
+//          (premiers k*2^N+1, k impair dans [A, B], B < 2^N, prouvés par le théorème de Proth)
+//        ComputeBigPrimesCPP --form riesel (--k-range A..B --n N | --k K --n-range A..B)
+//        ComputeBigPrimesCPP --form mersenne --n-range A..B
+//          (premiers k*2^n-1 et 2^n-1 : tests de Lucas-Lehmer-Riesel et de Lucas-Lehmer)
 
 #include <iostream>
-#include <vector>
-#include <random>
 #include <cstdint>
-#include <limits>
 #include <string>
 #include <sstream>
-#include <stdexcept>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <type_traits>
+
+#include "../Common/AsyncOutput.h"
+#include "../Common/Checkpoint.h"
+#include "../Common/Decimal.h"
+#include "../Common/GapFormat.h"
+#include "../Common/MappedFile.h"
+#include "../Common/PrimeBatch.h"
+#include "../Common/PrimeEngine.h"
+#include "../Common/PrimeServer.h"
+#include "../Common/Proth.h"
+#include "../Common/RawFormat.h"
+#include "../Common/LucasLehmer.h"
+#include "../PrimesLib/Primes.h"
 
-#include <boost/multiprecision/cpp_int.hpp>
-#include <boost/multiprecision/integer.hpp>
+using primes::cpp_int;
 
-using boost::multiprecision::cpp_int;
+// Montgomery générique (R = 2^r, r = taille de m) pour comparaison : REDC par
+// masques, décalages et deux produits pleine largeur.
+template <class W>
+struct MontgomeryWide {
+  W m, mask, m_prime; // m_prime = -m^-1 mod R
+  unsigned r;
 
-static const uint64_t SMALL_PRIMES[] = {
-    2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,71,
-    73,79,83,89,97,101,103,107,109,113,127,131,137,139,149,151,
-    157,163,167,173,179,181,191,193,197,199,211,223,227,229,233,
-    239,241,251,257,263,269,271,277,281,283,293,307,311,313,317,
-    331,337,347,349,353,359,367,373,379,383,389,397,401,409,419,
-    421,431,433,439,443,449,457,461,463,467,479,487,491,499
+  explicit MontgomeryWide(const W& mod) : m(mod), r(static_cast<unsigned>(boost::multiprecision::msb(mod)) + 1) {
+    mask = (W(1) << r) - 1;
+    W inv = m; // exact sur 3 bits (m impair), Newton double la précision
+    for (unsigned bits = 3; bits < r; bits *= 2) inv = (inv * ((mask + 3 - ((m * inv) & mask)) & mask)) & mask;
+    m_prime = (mask + 1 - inv) & mask;
+  }
+
+  W redc(const W& x) const {
+    const W q = ((x & mask) * m_prime) & mask;
+    const W t = (x + q * m) >> r;
+    return t >= m ? W(t - m) : t;
+  }
+
+  W to_mont(const W& x) const { return (x << r) % m; }
+
+  template <class T>
+  T pow(const T& base, T exp) const {
+    W b = to_mont(W(base) % m), res = to_mont(1);
+    while (exp != 0) {
+      if ((exp & 1) != 0) res = redc(res * b);
+      b = redc(b * b);
+      exp >>= 1;
+    }
+    return static_cast<T>(redc(res));
+  }
 };
-static const size_t SMALL_PRIME_COUNT = sizeof(SMALL_PRIMES) / sizeof(SMALL_PRIMES[0]);
 
-inline static cpp_int mulmod(const cpp_int& a, const cpp_int& b, const cpp_int& mod) {
-  return (a * b) % mod;
+// Temps moyen (µs) de f() sur `repeats` appels.
+template <class F>
+static double time_us(int repeats, F&& f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; ++r) f();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / repeats;
 }
 
-static cpp_int powmod(cpp_int base, cpp_int exp, const cpp_int& mod) {
-  cpp_int res = 1 % mod;
-  base %= mod;
-  while (exp > 0) {
-    if ((exp & 1) != 0) res = mulmod(res, base, mod);
-    base = mulmod(base, base, mod);
-    exp >>= 1;
+// powmod(a, m - 1, m) pour m = 2^k + c et 2^k - c : division, Montgomery générique
+// et réduction de forme spéciale (SpecialForm), avec vérification des résultats.
+template <class T, class W>
+static void bench_reduction(unsigned k, const char* type) {
+  const T c = 4046847; // 18446744073713598463 = 2^64 + 4046847
+  std::mt19937_64 rng(k);
+  for (int sign : { +1, -1 }) {
+    const T m = sign > 0 ? T((T(1) << k) + c) : T((T(1) << k) - c);
+    const T a = T(rng()) % m, e = m - 1;
+    const int repeats = std::max(1, static_cast<int>(200000 / (k * k / 64 + 1)));
+    const W wide = m;
+    const MontgomeryWide<W> mont(wide);
+    const primes::SpecialForm<W> form(wide);
+    T r_div = 0, r_mont = 0, r_form = 0;
+    const double t_div = time_us(repeats, [&] {
+      r_div = primes::powmod_with<T, W>(a, e, m, [&wide](const W& x) { return W(x % wide); });
+    });
+    const double t_mont = time_us(repeats, [&] { r_mont = mont.pow(a, e); });
+    const double t_form = time_us(repeats, [&] {
+      r_form = primes::powmod_with<T, W>(a, e, m, [&form](const W& x) { return form.reduce(x); });
+    });
+    std::cout << type << " 2^" << k << (sign > 0 ? " + " : " - ") << c << " : division " << t_div
+              << " us, Montgomery " << t_mont << " us, forme spéciale " << t_form << " us"
+              << (r_div == r_mont && r_div == r_form ? "" : "  (RÉSULTATS DIFFÉRENTS)") << '\n';
   }
-  return res;
 }
 
-static inline void decompose(const cpp_int& n, cpp_int& d, unsigned& s) {
-  d = n - 1;
-  s = 0;
-  while ((d & 1) == 0) { d >>= 1; ++s; }
+// Conversion décimale : operator<< de Boost face à DecimalWriter (puissances de 10 en
+// cache, deuxième appel), en Mo/s de chiffres.
+static void bench_decimal(size_t digits) {
+  std::mt19937_64 rng(digits);
+  cpp_int x = 0;
+  for (size_t bits = 0; bits < digits * 3.3219; bits += 64) {
+    x <<= 64;
+    x += rng();
+  }
+  primes::DecimalWriter writer;
+  writer.format(x);
+  std::string_view text;
+  const double t_writer = time_us(1, [&] { text = writer.format(x); });
+  std::cout << "décimal " << text.size() << " chiffres : DecimalWriter " << text.size() / t_writer << " Mo/s";
+  if (digits <= 100000) {
+    std::string reference;
+    const double t_boost = time_us(1, [&] { reference = x.str(); });
+    std::cout << ", Boost " << reference.size() / t_boost << " Mo/s" << (reference == text ? "" : "  (RÉSULTATS DIFFÉRENTS)");
+  }
+  std::cout << '\n';
+  const std::string digits_text(text);
+  primes::DecimalReader reader;
+  cpp_int parsed;
+  const double t_reader = time_us(1, [&] { parsed = reader.parse(digits_text.data(), digits_text.size()); });
+  std::cout << "lecture " << digits_text.size() << " chiffres : DecimalReader " << digits_text.size() / t_reader << " Mo/s";
+  if (digits <= 100000) {
+    cpp_int reference;
+    const double t_boost = time_us(1, [&] { reference = cpp_int(digits_text); });
+    std::cout << ", Boost " << digits_text.size() / t_boost << " Mo/s" << (reference == parsed ? "" : "  (RÉSULTATS DIFFÉRENTS)");
+  }
+  std::cout << (parsed == x ? "" : "  (RELECTURE DIFFÉRENTE)") << '\n';
 }
 
-static bool miller_rabin(const cpp_int& n, int rounds = 32, std::mt19937_64* rng_ptr = nullptr) {
-  if (n < 2) return false;
-  for (size_t i = 0; i < SMALL_PRIME_COUNT; ++i) {
-    uint64_t p = SMALL_PRIMES[i];
-    if (n == p) return true;
-    if (n % p == 0) return false;
-  }
-
-  cpp_int d; unsigned s;
-  decompose(n, d, s);
-
-  std::mt19937_64 local_rng(std::random_device{}());
-  std::mt19937_64& rng = rng_ptr ? *rng_ptr : local_rng;
-  std::uniform_int_distribution<uint64_t> dist64(2, std::numeric_limits<uint64_t>::max());
-
-  auto random_base = [&](const cpp_int& limit_minus_two)->cpp_int {
-    if (limit_minus_two <= 2) return cpp_int(2);
-    // calculer le nombre de "limbs" 64-bits nécessaires
-    unsigned long msb_index = boost::multiprecision::msb(limit_minus_two);
-    unsigned long bits = msb_index + 1;
-    size_t limbs = (bits + 63) / 64;
-    cpp_int a = 0;
-    for (size_t i = 0; i < limbs; ++i) {
-      a <<= 64;
-      a += cpp_int(dist64(rng));
-    }
-    // ramener dans [2, limit_minus_two]
-    if (a <= 1) a += 2;
-    a %= (limit_minus_two - 1);
-    a += 2;
-    return a;
-    };
+static void run_benchmark() {
+  bench_reduction<primes::uint128_t, primes::uint256_t>(64, "u128  ");
+  bench_reduction<primes::uint128_t, primes::uint256_t>(120, "u128  ");
+  bench_reduction<primes::fixed_uint<256>, primes::fixed_uint<512>>(200, "u256  ");
+  bench_reduction<primes::fixed_uint<512>, primes::fixed_uint<1024>>(500, "u512  ");
+  bench_reduction<cpp_int, cpp_int>(1024, "cpp_int");
+  bench_reduction<cpp_int, cpp_int>(4096, "cpp_int");
+  for (size_t digits : { 10000, 100000, 1000000 }) bench_decimal(digits);
+}
 
-  for (int t = 0; t < rounds; ++t) {
-    cpp_int a = random_base(n - 2);
-    cpp_int x = powmod(a, d, n);
-    if (x == 1 || x == n - 1) continue;
-    bool passed = false;
-    for (unsigned r = 1; r < s; ++r) {
-      x = mulmod(x, x, n);
-      if (x == n - 1) { passed = true; break; }
-    }
-    if (!passed) return false;
+// Entier de départ lu dans un fichier projeté en mémoire ; lève une exception en cas d'erreur.
+static cpp_int read_start_file(const std::string& path, std::string format) {
+  const primes::MappedFile file(path);
+  const char* text = file.data();
+  size_t len = file.size();
+  if (format == "limbs") {
+    // nombre de mots puis mots de 64 bits, poids faible d'abord (petit-boutiste)
+    if (len < 8) throw std::runtime_error("fichier limbs tronqué");
+    primes::u64 count = 0;
+    for (int i = 0; i < 8; ++i) count |= primes::u64(static_cast<unsigned char>(text[i])) << (8 * i);
+    if (count > (len - 8) / 8) throw std::runtime_error("fichier limbs tronqué");
+    cpp_int x;
+    boost::multiprecision::import_bits(x, reinterpret_cast<const unsigned char*>(text) + 8,
+                                       reinterpret_cast<const unsigned char*>(text) + 8 + 8 * count, 8, false);
+    return x;
   }
-  return true;
+  auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+  while (len > 0 && blank(*text)) { ++text; --len; }
+  while (len > 0 && blank(text[len - 1])) --len;
+  const bool prefixed = len > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+  if (format == "auto") format = prefixed ? "hex" : "decimal";
+  if (format == "hex") return prefixed ? primes::parse_hex(text + 2, len - 2) : primes::parse_hex(text, len);
+  if (format == "decimal") return primes::DecimalReader().parse(text, len);
+  throw std::invalid_argument("--start-format inconnu : " + format + " (auto, decimal, hex, limbs)");
 }
 
-static bool is_prime(const cpp_int& n, std::mt19937_64* rng_ptr = nullptr) {
-  if (n < 2) return false;
-  for (size_t i = 0; i < SMALL_PRIME_COUNT; ++i) {
-    uint64_t p = SMALL_PRIMES[i];
-    if (n == p) return true;
-    if (n % p == 0) return false;
+// "A..B" ou "A" (intervalle réduit à une valeur) ; faux si vide ou mal formé.
+static bool parse_range(const std::string& text, primes::u64& lo, primes::u64& hi) {
+  if (text.empty() || text.find_first_not_of("0123456789.") != std::string::npos) return false;
+  const size_t dots = text.find("..");
+  lo = std::stoull(text.substr(0, dots));
+  hi = dots == std::string::npos ? lo : std::stoull(text.substr(dots + 2));
+  return lo <= hi;
+}
+
+// Mode --form : premiers k*2^n+1 (proth) ou k*2^n-1 (riesel, mersenne pour k = 1),
+// criblés sur k à n fixé ou sur n à k fixé. Sortie par AsyncOutput, comme les autres modes.
+static int run_form(const std::string& form, const std::string& k_range, const std::string& n_range,
+                    const primes::GenerateOptions& options, const std::string& output,
+                    const primes::OutputOptions& output_options, bool output_stats) {
+  primes::u64 k_lo = 1, k_hi = 1, n_lo = 0, n_hi = 0;
+  const bool has_k = parse_range(k_range, k_lo, k_hi);
+  if (!parse_range(n_range, n_lo, n_hi) || (has_k != (form != "mersenne")) || (k_lo != k_hi && n_lo != n_hi)) {
+    std::cerr << "Usage : --form proth|riesel --k-range A..B --n N, --form riesel --k K --n-range A..B,"
+                 " --form mersenne --n-range A..B\n";
+    return 1;
+  }
+  std::unique_ptr<primes::WorkStealingPool> pool;
+  if (options.threads != 1) pool.reset(new primes::WorkStealingPool(options.threads));
+  const unsigned n = static_cast<unsigned>(n_lo);
+  // k < 2^n pour chaque n de l'intervalle, donc dès le plus petit
+  if (n_lo < 64 && k_hi >> n_lo != 0) {
+    std::cerr << "Ces tests demandent k < 2^n pour tout n de l'intervalle\n";
+    return 1;
+  }
+
+  if (form != "proth" && form != "riesel" && form != "mersenne") {
+    std::cerr << "Forme inconnue : " << form << " (proth, riesel, mersenne)\n";
+    return 1;
+  }
+  if (form == "proth" && (n < 2 || n_lo != n_hi)) {
+    std::cerr << "Théorème de Proth : n >= 2 fixé\n";
+    return 1;
+  }
+
+  std::unique_ptr<primes::AsyncOutput> sink;
+  try {
+    sink.reset(new primes::AsyncOutput(output, output_options));
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  std::ostream out(sink.get());
+  if (form == "proth") {
+    primes::proth_search(k_lo, k_hi, n, [n, &out, &sink](primes::u64 k) {
+      out << k << "*2^" << n << "+1\n";
+      sink->record_end();
+    }, pool.get());
+  }
+  else if (n_lo == n_hi && form == "riesel") {
+    primes::riesel_search_k(k_lo, k_hi, n, [n, &out, &sink](primes::u64 k) {
+      out << k << "*2^" << n << "-1\n";
+      sink->record_end();
+    }, pool.get());
+  }
+  else {
+    const primes::u64 k = k_lo;
+    primes::riesel_search_n(k, n, static_cast<unsigned>(n_hi), [k, &out, &sink](unsigned e) {
+      if (k == 1) out << "2^" << e << "-1\n";
+      else out << k << "*2^" << e << "-1\n";
+      sink->record_end();
+    }, pool.get());
+  }
+  if (!sink->close()) {
+    std::cerr << "Écriture impossible : " << (output.empty() ? "sortie standard" : output) << '\n';
+    return 1;
   }
-  return miller_rabin(n, 32, rng_ptr);
+  if (output_stats) primes::print_output_stats(sink->stats());
+  return 0;
 }
 
-static cpp_int next_candidate(cpp_int n) {
-  if (n <= 2) return 2;
-  if ((n & 1) == 0) ++n;
-  while (true) {
-    if (n % 3 != 0 && n % 5 != 0) return n;
-    n += 2;
+// Mode --check : entiers séparés par des blancs, lus par morceaux et testés par lots
+// de CHECK_CHUNK (is_prime_batch) ; une ligne 1 ou 0 par entier, dans l'ordre.
+static void run_check(std::istream& in, std::ostream& out, primes::AsyncOutput& sink, primes::PrimeContext& context) {
+  constexpr size_t CHECK_CHUNK = 1 << 16;
+  std::vector<cpp_int> values;
+  values.reserve(CHECK_CHUNK);
+  std::unique_ptr<bool[]> prime(new bool[CHECK_CHUNK]);
+  unsigned long long read = 0;
+  auto flush = [&]() {
+    context.is_prime_batch(values.data(), values.size(), prime.get());
+    for (size_t i = 0; i < values.size(); ++i) {
+      out.put(prime[i] ? '1' : '0');
+      out.put('\n');
+      sink.record_end();
+    }
+    values.clear();
+  };
+  auto add = [&](const char* text, size_t len) {
+    ++read;
+    // jusqu'à 19 chiffres : tient dans un u64, sans passer par DecimalReader
+    if (len <= 19 && text[0] != '0') {
+      primes::u64 x = 0;
+      size_t i = 0;
+      while (i < len && text[i] >= '0' && text[i] <= '9') x = x * 10 + primes::u64(text[i++] - '0');
+      if (i == len) {
+        values.emplace_back(x);
+        return;
+      }
+    }
+    try {
+      values.push_back(primes::parse_integer(text, len));
+    }
+    catch (const std::exception& e) {
+      throw std::invalid_argument("entier n° " + std::to_string(read) + " : " + e.what());
+    }
+  };
+
+  auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+  std::vector<char> chunk(1 << 20);
+  std::string token; // entier coupé en fin de morceau
+  while (in) {
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    const size_t got = static_cast<size_t>(in.gcount());
+    size_t i = 0;
+    while (i < got) {
+      size_t j = i;
+      while (j < got && !blank(chunk[j])) ++j;
+      if (j == got && in) {
+        token.append(chunk.data() + i, j - i);
+        break;
+      }
+      if (!token.empty()) {
+        token.append(chunk.data() + i, j - i);
+        add(token.data(), token.size());
+        token.clear();
+      }
+      else if (j > i) add(chunk.data() + i, j - i);
+      if (values.size() == CHECK_CHUNK) flush();
+      i = j;
+      while (i < got && blank(chunk[i])) ++i;
+    }
   }
+  if (!token.empty()) add(token.data(), token.size());
+  if (!values.empty()) flush();
 }
 
-static std::vector<cpp_int> generate_primes(cpp_int start, size_t count) {
-  std::vector<cpp_int> primes;
-  primes.reserve(count);
-  std::mt19937_64 rng(std::random_device{}());
-  cpp_int n = next_candidate(start);
-  if (n == 2) { primes.push_back(n); n = 3; }
-  while (primes.size() < count) {
-    if (is_prime(n, &rng)) primes.push_back(n);
-    n += 2;
-  }
-  return primes;
+// Réglages de PrimeContext (PrimesLib) tirés de ceux de la ligne de commande.
+static primes::PrimeOptions library_options(const primes::GenerateOptions& options) {
+  primes::PrimeOptions library;
+  library.threads = options.threads;
+  library.seed = options.seed;
+  library.bpsw = options.mr64 == primes::Mr64Mode::Bpsw;
+  library.pipeline = options.pipeline;
+  library.round_threads = options.round_threads;
+  library.round_threads_bits = options.round_threads_bits;
+  library.gerbicz = options.gerbicz;
+  return library;
 }
 
 int main(int argc, char** argv) {
@@ -131,23 +361,280 @@ int main(int argc, char** argv) {
 
   cpp_int start;
   size_t how_many = 100;
+  primes::GenerateOptions options;
+  bool bench = false;
+  std::string form;
+  std::string k_range;
+  std::string n_range;
+  std::string format = "decimal";
+  std::string output;
+  primes::OutputOptions output_options;
+  bool output_stats = false;
+  std::string decode;
+  unsigned long long decode_from = 0;
+  std::string start_file;
+  std::string start_format = "auto";
+  std::string checkpoint_file;
+  unsigned checkpoint_seconds = 60;
+  unsigned long long checkpoint_primes = 0;
+  std::string resume;
+  std::string serve;
+  bool check = false;
+  std::string direction = "up";
+  std::string check_file;
 
-  if (argc >= 2) {
-    std::istringstream iss(argv[1]);
-    if (!(iss >> start)) {
-      std::cerr << "Impossible de lire l'entier de départ.\n";
+  // options "--nom valeur", le reste est positionnel (start puis count)
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--pipeline") options.pipeline = true;
+    else if (arg == "--round-threads" && i + 1 < argc) options.round_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--round-threads-bits" && i + 1 < argc) options.round_threads_bits = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--ntt-threshold" && i + 1 < argc) primes::ntt_threshold_bits() = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--gerbicz") options.gerbicz = true;
+    else if (arg == "--bench") bench = true;
+    else if (arg == "--form" && i + 1 < argc) form = argv[++i];
+    else if ((arg == "--k-range" || arg == "--k") && i + 1 < argc) k_range = argv[++i];
+    else if ((arg == "--n-range" || arg == "--n") && i + 1 < argc) n_range = argv[++i];
+    else if (arg == "--format" && i + 1 < argc) format = argv[++i];
+    else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+    else if (arg == "--flush" && i + 1 < argc) {
+      const std::string policy = argv[++i];
+      if (!primes::parse_flush(policy, output_options)) {
+        std::cerr << "--flush inconnu : " << policy << " (full, line ou millisecondes)\n";
+        return 1;
+      }
+    }
+    else if (arg == "--output-stats") output_stats = true;
+    else if (arg == "--decode" && i + 1 < argc) decode = argv[++i];
+    else if (arg == "--from" && i + 1 < argc) decode_from = std::stoull(argv[++i]);
+    else if (arg == "--start-file" && i + 1 < argc) start_file = argv[++i];
+    else if (arg == "--start-format" && i + 1 < argc) start_format = argv[++i];
+    else if (arg == "--checkpoint" && i + 1 < argc) checkpoint_file = argv[++i];
+    else if (arg == "--checkpoint-every" && i + 1 < argc) checkpoint_seconds = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--checkpoint-primes" && i + 1 < argc) checkpoint_primes = std::stoull(argv[++i]);
+    else if (arg == "--resume" && i + 1 < argc) resume = argv[++i];
+    else if (arg == "--serve" && i + 1 < argc) serve = argv[++i];
+    else if (arg == "--direction" && i + 1 < argc) direction = argv[++i];
+    else if (arg == "--check") {
+      check = true;
+      if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) check_file = argv[++i];
+    }
+    else positional.push_back(arg);
+  }
+
+  if (bench) {
+    run_benchmark();
+    return 0;
+  }
+  if (!form.empty()) return run_form(form, k_range, n_range, options, output, output_options, output_stats);
+  if (!serve.empty()) {
+    try {
+      primes::serve(serve, options);
+    }
+    catch (const std::exception& e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+  if (check) {
+    try {
+      std::ifstream file;
+      if (!check_file.empty()) {
+        file.open(check_file, std::ios::binary);
+        if (!file) throw std::runtime_error("ouverture impossible : " + check_file);
+      }
+      primes::AsyncOutput sink(output, output_options);
+      std::ostream out(&sink);
+      primes::PrimeContext context(library_options(options));
+      run_check(check_file.empty() ? std::cin : file, out, sink, context);
+      if (!sink.close()) throw std::runtime_error("écriture impossible : " + (output.empty() ? std::string("sortie standard") : output));
+      if (output_stats) primes::print_output_stats(sink.stats());
+    }
+    catch (const std::exception& e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+  if (!decode.empty()) {
+    std::ifstream in(decode, std::ios::binary);
+    try {
+      primes::GapReader reader(in);
+      const unsigned long long count = positional.empty() ? reader.size() : std::stoull(positional[0]);
+      primes::AsyncOutput sink(std::string(), output_options);
+      std::ostream out(&sink);
+      primes::DecimalWriter decimal;
+      reader.read(decode_from, count, [&decimal, &out, &sink](const cpp_int& p) {
+        const std::string_view text = decimal.format(p);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out << '\n';
+        sink.record_end();
+      });
+      if (!sink.close()) throw std::runtime_error("écriture impossible sur la sortie standard");
+      if (output_stats) primes::print_output_stats(sink.stats());
+    }
+    catch (const std::exception& e) {
+      std::cerr << decode << " : " << e.what() << '\n';
       return 1;
     }
+    return 0;
+  }
+  // --resume : départ, nombre restant, graine, format et sortie viennent du point de reprise
+  primes::CheckpointState resumed;
+  if (!resume.empty()) {
+    try {
+      resumed = primes::load_checkpoint(resume);
+    }
+    catch (const std::exception& e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+    format = resumed.format;
+    output = resumed.output;
+    options.seed = resumed.seed;
+    output_options.resume = !output.empty();
+    output_options.resume_bytes = resumed.bytes;
+    if (checkpoint_file.empty()) checkpoint_file = resume;
+  }
+  if (direction != "up" && direction != "down") {
+    std::cerr << "--direction inconnu : " << direction << " (up ou down)\n";
+    return 1;
+  }
+  options.down = direction == "down";
+  if (options.down && (format == "gaps" || !checkpoint_file.empty())) {
+    std::cerr << "--direction down : formats decimal, hex ou limbs, sans point de reprise\n";
+    return 1;
+  }
+  if (!checkpoint_file.empty() && format == "gaps") {
+    std::cerr << "--checkpoint : formats decimal, hex ou limbs (le conteneur gaps s'écrit d'un seul tenant)\n";
+    return 1;
+  }
+
+  // --output vaut pour tous les formats ; obligatoire pour les formats binaires
+  const bool binary = format == "gaps" || format == "limbs";
+  if ((format != "decimal" && format != "hex" && !binary) || (binary && output.empty())) {
+    std::cerr << "--format decimal|hex [--output FICHIER], ou --format gaps|limbs --output FICHIER\n";
+    return 1;
+  }
+
+  if (!resume.empty()) {
+    start = resumed.next;
+    how_many = static_cast<size_t>(resumed.count - resumed.emitted);
+  }
+  else if (!start_file.empty()) {
+    // le départ vient du fichier : le seul positionnel est alors count
+    try {
+      start = read_start_file(start_file, start_format);
+    }
+    catch (const std::exception& e) {
+      std::cerr << start_file << " : " << e.what() << '\n';
+      return 1;
+    }
+    if (positional.size() >= 1) how_many = static_cast<size_t>(std::stoull(positional[0]));
   }
   else {
-    std::istringstream iss("18446744073713598463");
-    iss >> start;
+    if (positional.size() >= 1) {
+      std::istringstream iss(positional[0]);
+      if (!(iss >> start)) {
+        std::cerr << "Impossible de lire l'entier de départ.\n";
+        return 1;
+      }
+    }
+    else {
+      std::istringstream iss("18446744073713598463");
+      iss >> start;
+    }
+    if (positional.size() >= 2) how_many = static_cast<size_t>(std::stoull(positional[1]));
+  }
+
+  // sortie formatée par le calcul, écrite par un thread dédié (AsyncOutput.h)
+  std::unique_ptr<primes::AsyncOutput> sink;
+  try {
+    sink.reset(new primes::AsyncOutput(output, output_options));
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
   }
-  if (argc >= 3) how_many = static_cast<size_t>(std::stoull(argv[2]));
+  std::ostream out(sink.get());
 
-  auto primes = generate_primes(start, how_many);
-  for (size_t i = 0; i < primes.size(); ++i) {
-    std::cout << primes[i] << '\n';
+  primes::PrimeContext context(library_options(options));
+
+  // point de reprise : la sortie (et le tampon hex/limbs en cours) est vidée avant chaque écriture
+  primes::OutputBuffer* pending = nullptr;
+  std::unique_ptr<primes::Checkpointer> checkpoint;
+  if (!checkpoint_file.empty()) {
+    primes::CheckpointState state = resumed;
+    if (resume.empty()) {
+      state.start = start;
+      state.count = how_many;
+      state.next = start;
+      state.seed = context.seed();
+      state.format = format;
+      state.output = output;
+    }
+    checkpoint.reset(new primes::Checkpointer(checkpoint_file, state, checkpoint_seconds, checkpoint_primes,
+      [&pending, &sink](std::uint64_t& bytes) {
+        if (pending != nullptr) pending->flush();
+        if (!sink->drain()) return false;
+        bytes = sink->position();
+        return true;
+      }));
+  }
+
+  // chaque plage de valeurs est traitée par le moteur de la plus petite largeur qui la
+  // contient ; les premiers arrivent dans son type (PrimeSink)
+  auto generate = [&context, &start, how_many, &options](auto emit) {
+    auto target = primes::make_sink(emit);
+    if (options.down) context.generate_primes_down(start, how_many, target);
+    else context.generate_primes(start, how_many, target);
+  };
+  if (format == "gaps") {
+    primes::GapWriter writer(out);
+    generate([&writer](const auto& p) { writer.add(p); });
+    writer.finish();
+  }
+  else if (format == "decimal") {
+    // les cpp_int passent par DecimalWriter (operator<< de Boost est quadratique)
+    primes::DecimalWriter decimal;
+    auto print = [&decimal, &out, &sink, &checkpoint](const auto& p) {
+      if constexpr (std::is_same<std::decay_t<decltype(p)>, cpp_int>::value) {
+        const std::string_view text = decimal.format(p);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out << '\n';
+      }
+      else {
+        out << p << '\n';
+      }
+      sink->record_end();
+      if (checkpoint) checkpoint->record(p);
+    };
+    generate(print);
+  }
+  else {
+    primes::OutputBuffer buffer(out);
+    primes::RawWriter writer(buffer, format == "hex" ? primes::RawWriter::Format::Hex : primes::RawWriter::Format::Limbs);
+    pending = &buffer;
+    generate([&writer, &buffer, &sink, &checkpoint](const auto& p) {
+      writer.add(p);
+      if (sink->flush_due()) buffer.flush();
+      sink->record_end();
+      if (checkpoint) checkpoint->record(p);
+    });
+    buffer.flush();
+    pending = nullptr;
+  }
+  if (checkpoint) checkpoint->finish();
+  if (checkpoint && checkpoint->failures() != 0) {
+    std::cerr << checkpoint->failures() << " point(s) de reprise non écrit(s) : " << checkpoint_file << '\n';
+  }
+  if (!sink->close()) {
+    std::cerr << "Écriture impossible : " << (output.empty() ? "sortie standard" : output) << '\n';
+    return 1;
   }
+  if (output_stats) primes::print_output_stats(sink->stats());
   return 0;
 }
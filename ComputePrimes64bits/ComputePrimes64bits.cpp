@@ -1,161 +1,219 @@
 // next_primes_uint64.cpp
-// Trouve `count` nombres premiers >= start (uint64_t).
+// Trouve `count` nombres premiers >= start : moteur uint64_t, relayé par les moteurs
+// 128 bits, à taille fixe puis multiprécision (Boost) quand les candidats dépassent 2^64.
 // Conçu pour MSVC (Visual Studio 2022) et compatible g++/clang.
 //
-// Usage:
-//  - Sous Visual Studio : créer un projet Console, ajouter ce fichier et build/run.
-//  - En ligne de commande g++: g++ -O3 -std=c++17 next_primes_uint64.cpp -o next_primes
+// Usage: ComputePrimes64bits [start] [count] [--mr bases7|bpsw] [--threads N [--pipeline]] [--bench]
+//                            [--format decimal|hex|gaps|limbs] [--output FICHIER]
+//                            [--flush full|line|MS] [--output-stats] [--direction up|down]
+//  - --direction down : les `count` premiers <= start, du plus grand au plus petit ; s'arrête
+//    à 2 (moins de `count` premiers si start est petit) ; pas de --pipeline ni de format gaps
+//  - la sortie est écrite par un thread dédié (AsyncOutput.h) ; --flush : blocs pleins
+//    seulement, chaque ligne, ou après MS millisecondes sans écriture ; --output-stats
+//    affiche sur stderr les octets écrits et les attentes du calcul
+//  - --format gaps : conteneur binaire d'écarts (GapFormat.h), relu par ComputeBigPrimesCPP --decode
+//  - --format hex / limbs : hexadécimal, ou mots de 64 bits précédés de leur nombre (RawFormat.h)
+//  - la génération passe par PrimeContext (PrimesLib), sans conversion des premiers
+//  - Sous Visual Studio : projet Console référençant PrimesLib (voir la solution).
+//  - En ligne de commande g++: g++ -O3 -std=c++17 -pthread next_primes_uint64.cpp ../PrimesLib/Primes.cpp -o next_primes
 
 #include <iostream>
-#include <vector>
 #include <cstdint>
-#include <random>
-#include <limits>
 #include <string>
-
-// Détection MSVC pour utiliser _umul128
-#ifdef _MSC_VER
-#include <intrin.h>
-#endif
-
-using u64 = uint64_t;
-//using u128 = unsigned __int128; // utilisé uniquement sur GCC/Clang
-
-// Multiplie a * b mod m sans overflow pour 64 bits.
-// Implémentation portable : utilise _umul128 sur MSVC, __uint128_t sinon.
-static inline u64 mul_mod(u64 a, u64 b, u64 mod) {
-#ifdef _MSC_VER
-  // MSVC : _umul128 retourne la partie basse et la partie haute dans *high
-  unsigned long long high;
-  unsigned long long low = _umul128(a, b, &high);
-  // on a 128-bit = (high << 64) | low. On doit faire (a*b) % mod.
-  // Réduction par division 128/64 (utilise builtin 128 via pair high/low).
-  // On convertit en builtin 128 pour simplifier la division si possible:
-  // MSVC ne supporte __uint128_t ; simulons la division en utilisant
-  // l'algorithme de réduction double-and-add — mais pour simplicité et
-  // performance, utilisons long double trick si mod fits in 64 bits.
-  // Simpler approach: use builtin algorithm: (a*b - q*mod) where q = (unsigned __int128)(a*b)/mod
-  // But MSVC lacks unsigned __int128. So we'll implement 128-bit division manually:
-  // Use std::uint64_t high, low and perform manual division (Knuth) — but that's long.
-  // Simpler and sufficiently fast: use loop doubling (binary method).
-  u64 result = 0;
-  u64 base = a % mod;
-  u64 bb = b;
-  while (bb) {
-    if (bb & 1) {
-      // result = (result + base) % mod, avoid overflow by subtraction
-      u64 tmp = result + base;
-      if (tmp < result || tmp >= mod) tmp = (tmp % mod);
-      result = tmp % mod;
-    }
-
-    bb >>= 1;
-    if (bb) {
-      // base = (base * 2) % mod, safe
-      base = base + base;
-      if (base >= mod || base < base - base) base %= mod;
-    }
-  }
-
-  return result % mod;
-#else
-  // GCC/Clang : on a __uint128_t
-  u128 res = (u128)a * (u128)b;
-  res %= mod;
-  return (u64)res;
-#endif
-}
-
-// Exponentiation modulaire
-static inline u64 pow_mod(u64 a, u64 d, u64 mod) {
-  u64 res = 1;
-  a %= mod;
-  while (d) {
-    if (d & 1) res = mul_mod(res, a, mod);
-    a = mul_mod(a, a, mod);
-    d >>= 1;
-  }
-
-  return res;
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "../Common/AsyncOutput.h"
+#include "../Common/GapFormat.h"
+#include "../Common/PrimeEngine.h"
+#include "../Common/RawFormat.h"
+#include "../PrimesLib/Primes.h"
+
+using primes::cpp_int;
+using primes::u64;
+
+// Temps moyen par candidat (ns) de `test` sur `candidates`.
+static double time_per_candidate(const std::vector<u64>& candidates,
+                                 const std::function<size_t(const std::vector<u64>&)>& test) {
+  const int repeats = 5;
+  volatile size_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; ++r) sink = sink + test(candidates);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / (repeats * candidates.size());
 }
 
-// Miller-Rabin déterministe pour 64-bit (bases spéciales)
-static bool is_prime_u64(u64 n) {
-  if (n < 2) return false;
-  static const u64 small_primes[] = {
-      2ull,3ull,5ull,7ull,11ull,13ull,17ull,19ull,23ull,29ull,31ull,37ull
-  };
-  for (u64 p : small_primes) {
-    if (n == p) return true;
-    if (n % p == 0) return false;
-  }
-
-  // écrire n-1 = d * 2^s
-  u64 d = n - 1;
-  int s = 0;
-  while ((d & 1) == 0) { d >>= 1; ++s; }
-
-  // bases déterministes pour n < 2^64
-  const u64 bases[] = { 2ull, 325ull, 9375ull, 28178ull, 450775ull, 9780504ull, 1795265022ull };
-
-  for (u64 a : bases) {
-    if (a % n == 0) continue;
-    u64 x = pow_mod(a, d, n);
-    if (x == 1 || x == n - 1) continue;
-    bool composite = true;
-    for (int r = 1; r < s; ++r) {
-      x = mul_mod(x, x, n);
-      if (x == n - 1) { composite = false; break; }
+// --bench : probable_prime (une chaîne de multiplications) face à probable_prime_batch
+// (lots de 64, 4 chaînes entrelacées), sur les survivants du crible à partir de start puis sur les
+// seuls premiers (pire cas : toutes les bases sont calculées).
+static void run_benchmark(u64 start) {
+  using Engine = primes::PrimeEngine<primes::Arith64>;
+  std::vector<u64> survivors, found;
+  std::vector<char> composite(primes::SIEVE_WINDOW);
+  // au moins 2^33 (chemin 64 bits) et assez de place sous 2^64 pour 200 000 survivants
+  const u64 room = u64(1) << 32;
+  u64 n = Engine::next_candidate(std::min(std::max<u64>(start, u64(1) << 33),
+                                          std::numeric_limits<u64>::max() - room));
+  while (survivors.size() < 200000 && n < std::numeric_limits<u64>::max() - 2 * primes::SIEVE_WINDOW) {
+    Engine::sieve_window(n, primes::SIEVE_WINDOW, composite.data());
+    for (size_t j = 0; j < primes::SIEVE_WINDOW; ++j) {
+      if (!composite[j]) survivors.push_back(n + 2 * j);
     }
-    if (composite) return false;
+    n += 2 * primes::SIEVE_WINDOW;
   }
-
-  return true;
-}
-
-// Renvoie le prochain candidat impair >= n
-static u64 next_candidate_u64(u64 n) {
-  if (n <= 2) return 2;
-  if ((n & 1) == 0) ++n;
-  // skip multiples of 3 quickly
-  while (n % 3 == 0) n += 2;
-  return n;
-}
-
-static std::vector<u64> generate_primes_u64(u64 start, size_t count) {
-  std::vector<u64> primes;
-  primes.reserve(count);
-  u64 n = next_candidate_u64(start);
-  if (n == 2) { primes.push_back(2); n = 3; }
-  while (primes.size() < count) {
-    if (is_prime_u64(n)) primes.push_back(n);
-    if (n >= std::numeric_limits<u64>::max() - 2) break; // sécurité
-    n += 2;
+  primes::Arith64 reference;
+  for (u64 c : survivors) {
+    if (reference.probable_prime(c)) found.push_back(c);
   }
 
-  return primes;
+  std::cout << "candidats : " << survivors.size() << " survivants du crible, " << found.size() << " premiers\n";
+  for (primes::Mr64Mode mode : { primes::Mr64Mode::Bases7, primes::Mr64Mode::Bpsw }) {
+    primes::Arith64 arith(mode);
+    auto single = [&arith](const std::vector<u64>& v) {
+      size_t k = 0;
+      for (u64 c : v) k += arith.probable_prime(c);
+      return k;
+    };
+    auto batch = [&arith](const std::vector<u64>& v) {
+      size_t k = 0;
+      bool out[64];
+      for (size_t i = 0; i < v.size(); i += 64) {
+        const size_t len = std::min<size_t>(64, v.size() - i);
+        arith.probable_prime_batch(&v[i], out, len);
+        for (size_t j = 0; j < len; ++j) k += out[j];
+      }
+      return k;
+    };
+    const char* name = mode == primes::Mr64Mode::Bpsw ? "bpsw  " : "bases7";
+    std::cout << name << " survivants : " << time_per_candidate(survivors, single) << " ns (1 voie), "
+              << time_per_candidate(survivors, batch) << " ns (lots)\n";
+    std::cout << name << " premiers   : " << time_per_candidate(found, single) << " ns (1 voie), "
+              << time_per_candidate(found, batch) << " ns (lots)\n";
+  }
 }
 
 int main(int argc, char** argv) {
-  u64 start = 18446744073709551615ULL; // exemple fourni
+  cpp_int start = 18446744073709551615ULL; // exemple fourni
   size_t count = 100;
-  if (argc >= 2) {
-    // lire en decimal (potentiellement grand)
-    try {
-      std::string s = argv[1];
-      // stoi pour unsigned long long
-      start = std::stoull(s);
+  primes::PrimeOptions options;
+  bool down = false;
+  bool bench = false;
+  std::string format = "decimal";
+  std::string output;
+  primes::OutputOptions output_options;
+  bool output_stats = false;
+
+  // options "--nom valeur", le reste est positionnel (start puis count)
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--mr" && i + 1 < argc) {
+      std::string mode = argv[++i];
+      if (mode == "bases7") options.bpsw = false;
+      else if (mode == "bpsw") options.bpsw = true;
+      else {
+        std::cerr << "Mode --mr inconnu : " << mode << " (bases7 ou bpsw)\n";
+        return 1;
+      }
     }
-    catch (...) {
+    else if (arg == "--threads" && i + 1 < argc) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (arg == "--pipeline") options.pipeline = true;
+    else if (arg == "--bench") bench = true;
+    else if (arg == "--format" && i + 1 < argc) format = argv[++i];
+    else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+    else if (arg == "--flush" && i + 1 < argc) {
+      const std::string policy = argv[++i];
+      if (!primes::parse_flush(policy, output_options)) {
+        std::cerr << "--flush inconnu : " << policy << " (full, line ou millisecondes)\n";
+        return 1;
+      }
+    }
+    else if (arg == "--output-stats") output_stats = true;
+    else if (arg == "--direction" && i + 1 < argc) {
+      const std::string direction = argv[++i];
+      if (direction != "up" && direction != "down") {
+        std::cerr << "--direction inconnu : " << direction << " (up ou down)\n";
+        return 1;
+      }
+      down = direction == "down";
+    }
+    else positional.push_back(arg);
+  }
+
+  if (positional.size() >= 1) {
+    // lire en decimal (potentiellement au-delà de 64 bits)
+    const std::string& s = positional[0];
+    std::istringstream iss(s);
+    if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos || !(iss >> start)) {
       std::cerr << "Argument invalide pour start\n";
       return 1;
     }
   }
-  if (argc >= 3) {
-    count = static_cast<size_t>(std::stoull(argv[2]));
+  if (positional.size() >= 2) {
+    count = static_cast<size_t>(std::stoull(positional[1]));
+  }
+
+  if (bench) {
+    run_benchmark(start > std::numeric_limits<u64>::max() ? std::numeric_limits<u64>::max() : start.convert_to<u64>());
+    return 0;
   }
 
-  auto primes = generate_primes_u64(start, count);
-  for (u64 p : primes) std::cout << p << '\n';
+  // --output vaut pour tous les formats ; obligatoire pour les formats binaires
+  const bool binary = format == "gaps" || format == "limbs";
+  if ((format != "decimal" && format != "hex" && !binary) || (binary && output.empty())) {
+    std::cerr << "--format decimal|hex [--output FICHIER], ou --format gaps|limbs --output FICHIER\n";
+    return 1;
+  }
+  if (down && format == "gaps") {
+    std::cerr << "--direction down : formats decimal, hex ou limbs (le format gaps est croissant)\n";
+    return 1;
+  }
+  // sortie formatée par le calcul, écrite par un thread dédié (AsyncOutput.h)
+  std::unique_ptr<primes::AsyncOutput> sink;
+  try {
+    sink.reset(new primes::AsyncOutput(output, output_options));
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  std::ostream out(sink.get());
+
+  // chaque premier arrive dans le type de son moteur (PrimeSink)
+  primes::PrimeContext context(options);
+  auto generate = [&context, &start, count, down](auto emit) {
+    auto target = primes::make_sink(emit);
+    if (down) context.generate_primes_down(start, count, target);
+    else context.generate_primes(start, count, target);
+  };
+  if (format == "gaps") {
+    primes::GapWriter writer(out);
+    generate([&writer](const auto& p) { writer.add(p); });
+    writer.finish();
+  }
+  else if (format == "decimal") {
+    generate([&out, &sink](const auto& p) {
+      out << p << '\n';
+      sink->record_end();
+    });
+  }
+  else {
+    primes::OutputBuffer buffer(out);
+    primes::RawWriter writer(buffer, format == "hex" ? primes::RawWriter::Format::Hex : primes::RawWriter::Format::Limbs);
+    generate([&writer, &buffer, &sink](const auto& p) {
+      writer.add(p);
+      if (sink->flush_due()) buffer.flush();
+      sink->record_end();
+    });
+    buffer.flush();
+  }
+  if (!sink->close()) {
+    std::cerr << "Écriture impossible : " << (output.empty() ? "sortie standard" : output) << '\n';
+    return 1;
+  }
+  if (output_stats) primes::print_output_stats(sink->stats());
   return 0;
 }
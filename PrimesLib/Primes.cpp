@@ -0,0 +1,327 @@
+// Primes.cpp
+// PrimesLib : PrimeContext et l'interface C, au-dessus des moteurs de Common/.
+
+#include "Primes.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "../Common/PrimeBatch.h"
+#include "../Common/PrimeEngine.h"
+
+namespace primes {
+
+struct PrimeContext::Impl {
+  explicit Impl(const GenerateOptions& options)
+    : opt(options), tester(options), engine64(Arith64(options.mr64)) {
+    if (opt.threads != 1) pool.reset(new WorkStealingPool(opt.threads));
+  }
+
+  GenerateOptions opt;
+  PrimeTester tester;
+  PrimeEngine<Arith64> engine64;
+  std::unique_ptr<WorkStealingPool> pool;
+};
+
+namespace {
+
+// PrimeSink nomme les fixed_uint par leurs alias Boost
+static_assert(std::is_same<fixed_uint<256>, boost::multiprecision::uint256_t>::value, "fixed_uint<256>");
+static_assert(std::is_same<fixed_uint<512>, boost::multiprecision::uint512_t>::value, "fixed_uint<512>");
+static_assert(std::is_same<fixed_uint<1024>, boost::multiprecision::uint1024_t>::value, "fixed_uint<1024>");
+
+GenerateOptions context_options(unsigned threads, std::uint64_t seed) {
+  GenerateOptions opt;
+  opt.threads = threads;
+  if (seed != 0) opt.seed = seed;
+  return opt;
+}
+
+GenerateOptions context_options(const PrimeOptions& options) {
+  GenerateOptions opt;
+  opt.threads = options.threads;
+  opt.seed = options.seed;
+  opt.mr64 = options.bpsw ? Mr64Mode::Bpsw : Mr64Mode::Bases7;
+  opt.pipeline = options.pipeline;
+  opt.round_threads = options.round_threads;
+  opt.round_threads_bits = options.round_threads_bits;
+  opt.gerbicz = options.gerbicz;
+  return opt;
+}
+
+// les u32 du moteur 32 bits passent par emit(u64)
+auto to_sink(PrimeSink& sink) {
+  return [&sink](const auto& p) {
+    if constexpr (std::is_same<std::decay_t<decltype(p)>, u32>::value) sink.emit(u64(p));
+    else sink.emit(p);
+  };
+}
+
+} // namespace
+
+PrimeContext::PrimeContext(unsigned threads, std::uint64_t seed) : impl_(new Impl(context_options(threads, seed))) {}
+
+PrimeContext::PrimeContext(const PrimeOptions& options) : impl_(new Impl(context_options(options))) {}
+
+PrimeContext::~PrimeContext() = default;
+
+std::uint64_t PrimeContext::seed() const {
+  return impl_->opt.seed;
+}
+
+bool PrimeContext::is_prime(std::uint64_t n) {
+  return impl_->engine64.is_prime(n);
+}
+
+bool PrimeContext::is_prime(const cpp_int& n) {
+  return impl_->tester.is_prime(n);
+}
+
+PrimeContext::cpp_int PrimeContext::next_prime(const cpp_int& n) {
+  cpp_int p;
+  generate_primes_hybrid(n < 0 ? cpp_int(0) : cpp_int(n + 1), 1, [&p](const auto& q) { p = q; }, impl_->opt,
+                         impl_->pool.get());
+  return p;
+}
+
+PrimeContext::cpp_int PrimeContext::prev_prime(const cpp_int& n) {
+  cpp_int p = 0;
+  GenerateOptions opt = impl_->opt;
+  opt.down = true;
+  generate_primes_hybrid(n - 1, 1, [&p](const auto& q) { p = q; }, opt, impl_->pool.get());
+  return p;
+}
+
+std::vector<PrimeContext::cpp_int> PrimeContext::generate_primes(const cpp_int& start, std::size_t count) {
+  std::vector<cpp_int> primes;
+  primes.reserve(count);
+  generate_primes(start, count, [&primes](const cpp_int& p) { primes.push_back(p); });
+  return primes;
+}
+
+void PrimeContext::generate_primes(const cpp_int& start, std::size_t count,
+                                   const std::function<void(const cpp_int&)>& emit) {
+  generate_primes_hybrid(start, count, [&emit](const auto& p) { emit(cpp_int(p)); }, impl_->opt, impl_->pool.get());
+}
+
+std::size_t PrimeContext::generate_primes(const cpp_int& start, std::size_t count, PrimeSink& sink) {
+  return generate_primes_hybrid(start, count, to_sink(sink), impl_->opt, impl_->pool.get());
+}
+
+std::vector<std::uint64_t> PrimeContext::generate_primes_u64(std::uint64_t start, std::size_t count) {
+  std::vector<std::uint64_t> primes;
+  primes.reserve(count);
+  impl_->engine64.generate(start, count, [&primes](std::uint64_t p) { primes.push_back(p); }, impl_->pool.get());
+  return primes;
+}
+
+std::vector<PrimeContext::cpp_int> PrimeContext::generate_primes_down(const cpp_int& start, std::size_t count) {
+  std::vector<cpp_int> primes;
+  generate_primes_down(start, count, [&primes](const cpp_int& p) { primes.push_back(p); });
+  return primes;
+}
+
+void PrimeContext::generate_primes_down(const cpp_int& start, std::size_t count,
+                                        const std::function<void(const cpp_int&)>& emit) {
+  GenerateOptions opt = impl_->opt;
+  opt.down = true;
+  generate_primes_hybrid(start, count, [&emit](const auto& p) { emit(cpp_int(p)); }, opt, impl_->pool.get());
+}
+
+std::vector<std::uint64_t> PrimeContext::generate_primes_u64_down(std::uint64_t start, std::size_t count) {
+  std::vector<std::uint64_t> primes;
+  impl_->engine64.generate_down(start, count, [&primes](std::uint64_t p) { primes.push_back(p); }, impl_->pool.get());
+  return primes;
+}
+
+std::size_t PrimeContext::generate_primes_down(const cpp_int& start, std::size_t count, PrimeSink& sink) {
+  GenerateOptions opt = impl_->opt;
+  opt.down = true;
+  return generate_primes_hybrid(start, count, to_sink(sink), opt, impl_->pool.get());
+}
+
+void PrimeContext::is_prime_batch(const std::uint64_t* n, std::size_t len, bool* out) {
+  primes::is_prime_batch(n, len, out, impl_->opt, impl_->pool.get());
+}
+
+void PrimeContext::is_prime_batch(const cpp_int* n, std::size_t len, bool* out) {
+  primes::is_prime_batch(n, len, out, impl_->opt, impl_->pool.get());
+}
+
+} // namespace primes
+
+// ---- interface C ----
+
+struct primes_context {
+  primes_context(unsigned threads, uint64_t seed) : cpp(threads, seed) {}
+  primes::PrimeContext cpp;
+};
+
+namespace {
+
+using primes::cpp_int;
+
+cpp_int from_limbs(const uint64_t* limbs, size_t len) {
+  cpp_int x = 0;
+  if (len != 0) boost::multiprecision::import_bits(x, limbs, limbs + len, 64, false);
+  return x;
+}
+
+// nombre de mots de x (au moins un), copiés dans out s'ils tiennent dans capacity
+size_t to_limbs(const cpp_int& x, uint64_t* out, size_t capacity) {
+  std::vector<uint64_t> limbs;
+  if (x != 0) boost::multiprecision::export_bits(x, std::back_inserter(limbs), 64, false);
+  if (limbs.empty()) limbs.push_back(0);
+  if (limbs.size() <= capacity) std::copy(limbs.begin(), limbs.end(), out);
+  return limbs.size();
+}
+
+// arrêt demandé par le rappel de primes_generate
+struct StopGenerate {};
+
+} // namespace
+
+extern "C" {
+
+primes_context* primes_create(unsigned threads, uint64_t seed) {
+  try {
+    return new primes_context(threads, seed);
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+void primes_destroy(primes_context* ctx) {
+  delete ctx;
+}
+
+int primes_is_prime_u64(primes_context* ctx, uint64_t n) {
+  if (ctx == nullptr) return -1;
+  return ctx->cpp.is_prime(n) ? 1 : 0;
+}
+
+int primes_is_prime(primes_context* ctx, const uint64_t* limbs, size_t len) {
+  if (ctx == nullptr || (limbs == nullptr && len != 0)) return -1;
+  try {
+    return ctx->cpp.is_prime(from_limbs(limbs, len)) ? 1 : 0;
+  }
+  catch (...) {
+    return -1;
+  }
+}
+
+uint64_t primes_next_prime_u64(primes_context* ctx, uint64_t n) {
+  if (ctx == nullptr || n == std::numeric_limits<uint64_t>::max()) return 0;
+  try {
+    const std::vector<uint64_t> p = ctx->cpp.generate_primes_u64(n + 1, 1);
+    return p.empty() ? 0 : p[0];
+  }
+  catch (...) {
+    return 0;
+  }
+}
+
+uint64_t primes_prev_prime_u64(primes_context* ctx, uint64_t n) {
+  if (ctx == nullptr || n <= 2) return 0;
+  try {
+    const std::vector<uint64_t> p = ctx->cpp.generate_primes_u64_down(n - 1, 1);
+    return p.empty() ? 0 : p[0];
+  }
+  catch (...) {
+    return 0;
+  }
+}
+
+size_t primes_next_prime(primes_context* ctx, const uint64_t* limbs, size_t len, uint64_t* out, size_t capacity) {
+  if (ctx == nullptr || (limbs == nullptr && len != 0) || (out == nullptr && capacity != 0)) return 0;
+  try {
+    return to_limbs(ctx->cpp.next_prime(from_limbs(limbs, len)), out, capacity);
+  }
+  catch (...) {
+    return 0;
+  }
+}
+
+size_t primes_generate_u64(primes_context* ctx, uint64_t start, size_t count, uint64_t* out) {
+  if (ctx == nullptr || (out == nullptr && count != 0)) return 0;
+  try {
+    const std::vector<uint64_t> p = ctx->cpp.generate_primes_u64(start, count);
+    std::copy(p.begin(), p.end(), out);
+    return p.size();
+  }
+  catch (...) {
+    return 0;
+  }
+}
+
+size_t primes_generate_down_u64(primes_context* ctx, uint64_t start, size_t count, uint64_t* out) {
+  if (ctx == nullptr || (out == nullptr && count != 0)) return 0;
+  try {
+    const std::vector<uint64_t> p = ctx->cpp.generate_primes_u64_down(start, count);
+    std::copy(p.begin(), p.end(), out);
+    return p.size();
+  }
+  catch (...) {
+    return 0;
+  }
+}
+
+size_t primes_generate(primes_context* ctx, const uint64_t* limbs, size_t len, size_t count, primes_emit emit,
+                       void* user) {
+  if (ctx == nullptr || emit == nullptr || (limbs == nullptr && len != 0)) return PRIMES_GENERATE_ERROR;
+  size_t emitted = 0;
+  try {
+    std::vector<uint64_t> buffer;
+    ctx->cpp.generate_primes(from_limbs(limbs, len), count, [&](const cpp_int& p) {
+      buffer.clear();
+      boost::multiprecision::export_bits(p, std::back_inserter(buffer), 64, false);
+      ++emitted;
+      if (emit(user, buffer.data(), buffer.size()) == 0) throw StopGenerate();
+    });
+  }
+  catch (const StopGenerate&) {
+  }
+  catch (...) {
+    return PRIMES_GENERATE_ERROR;
+  }
+  return emitted;
+}
+
+int primes_is_prime_batch_u64(primes_context* ctx, const uint64_t* n, size_t count, unsigned char* out) {
+  if (ctx == nullptr || ((n == nullptr || out == nullptr) && count != 0)) return -1;
+  try {
+    std::unique_ptr<bool[]> prime(new bool[count]);
+    ctx->cpp.is_prime_batch(n, count, prime.get());
+    for (size_t i = 0; i < count; ++i) out[i] = prime[i] ? 1 : 0;
+    return 0;
+  }
+  catch (...) {
+    return -1;
+  }
+}
+
+int primes_is_prime_batch(primes_context* ctx, const uint64_t* const* limbs, const size_t* lens, size_t count,
+                          unsigned char* out) {
+  if (ctx == nullptr || ((limbs == nullptr || lens == nullptr || out == nullptr) && count != 0)) return -1;
+  try {
+    std::vector<cpp_int> n;
+    n.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      if (limbs[i] == nullptr && lens[i] != 0) return -1;
+      n.push_back(from_limbs(limbs[i], lens[i]));
+    }
+    std::unique_ptr<bool[]> prime(new bool[count]);
+    ctx->cpp.is_prime_batch(n.data(), count, prime.get());
+    for (size_t i = 0; i < count; ++i) out[i] = prime[i] ? 1 : 0;
+    return 0;
+  }
+  catch (...) {
+    return -1;
+  }
+}
+
+} // extern "C"
@@ -0,0 +1,125 @@
+// Primes.h
+// Interface C++ de la bibliothèque PrimesLib (projet statique PrimesLib, projet partagé
+// PrimesDll) : les moteurs de Common/ compilés une fois, appelables sans lancer
+// d'exécutable ni passer par du texte. L'interface C est dans PrimesC.h.
+//  - g++ statique : g++ -O3 -std=c++17 -pthread -c Primes.cpp && ar rcs libprimes.a Primes.o
+//  - g++ partagée : g++ -O3 -std=c++17 -pthread -fPIC -fvisibility=hidden -DPRIMES_SHARED
+//                   -DPRIMES_BUILD -shared Primes.cpp -o libprimes.so
+//
+// Un PrimeContext garde ses moteurs, ses générateurs et son pool de threads d'un appel
+// à l'autre ; il n'est pas partagé entre threads (un contexte par thread appelant).
+// Les exécutables génèrent par un PrimeSink : chaque premier arrive dans le type du
+// moteur qui l'a trouvé, sans passer par cpp_int.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "PrimesC.h"
+
+namespace primes {
+
+// Réglages d'un PrimeContext (ceux de GenerateOptions, PrimeEngine.h).
+struct PrimeOptions {
+  unsigned threads = 1;                          // 1 séquentiel, 0 un par cœur
+  std::uint64_t seed = std::random_device{}();   // bases aléatoires au-delà de 2^81
+  bool bpsw = false;                             // candidats 64 bits : BPSW au lieu des 7 bases
+  bool pipeline = false;                         // avec threads != 1 : crible -> test -> sortie
+  unsigned round_threads = 1;                    // threads par candidat (tours de Miller-Rabin) ...
+  unsigned round_threads_bits = 16384;           // ... à partir de cette taille en bits
+  bool gerbicz = false;                          // contrôle de Gerbicz (candidats NTT)
+};
+
+// Destination des premiers d'une génération, un emit par largeur de moteur : u64
+// (u32 compris), 128, 256, 512, 1024 bits (les fixed_uint de Arithmetic.h), cpp_int.
+class PrimeSink {
+public:
+  using cpp_int = boost::multiprecision::cpp_int;
+
+  virtual ~PrimeSink() = default;
+  virtual void emit(std::uint64_t p) = 0;
+  virtual void emit(const boost::multiprecision::uint128_t& p) = 0;
+  virtual void emit(const boost::multiprecision::uint256_t& p) = 0;
+  virtual void emit(const boost::multiprecision::uint512_t& p) = 0;
+  virtual void emit(const boost::multiprecision::uint1024_t& p) = 0;
+  virtual void emit(const cpp_int& p) = 0;
+};
+
+// PrimeSink passant chaque premier à une lambda générique (const auto& p).
+template <class Emit>
+class EmitSink final : public PrimeSink {
+public:
+  explicit EmitSink(Emit& emit) : emit_(emit) {}
+
+  void emit(std::uint64_t p) override { emit_(p); }
+  void emit(const boost::multiprecision::uint128_t& p) override { emit_(p); }
+  void emit(const boost::multiprecision::uint256_t& p) override { emit_(p); }
+  void emit(const boost::multiprecision::uint512_t& p) override { emit_(p); }
+  void emit(const boost::multiprecision::uint1024_t& p) override { emit_(p); }
+  void emit(const cpp_int& p) override { emit_(p); }
+
+private:
+  Emit& emit_;
+};
+
+template <class Emit>
+EmitSink<Emit> make_sink(Emit& emit) {
+  return EmitSink<Emit>(emit);
+}
+
+class PRIMES_API PrimeContext {
+public:
+  using cpp_int = boost::multiprecision::cpp_int;
+
+  // threads : 1 séquentiel, 0 un par cœur (generate_primes) ; seed = 0 : graine aléatoire
+  explicit PrimeContext(unsigned threads = 1, std::uint64_t seed = 0);
+  explicit PrimeContext(const PrimeOptions& options);
+  ~PrimeContext();
+
+  PrimeContext(const PrimeContext&) = delete;
+  PrimeContext& operator=(const PrimeContext&) = delete;
+
+  // Graine des bases aléatoires (à conserver pour reproduire une génération).
+  std::uint64_t seed() const;
+
+  bool is_prime(std::uint64_t n);
+  bool is_prime(const cpp_int& n);
+
+  // Plus petit premier > n.
+  cpp_int next_prime(const cpp_int& n);
+
+  // Plus grand premier < n, ou 0 si n <= 2.
+  cpp_int prev_prime(const cpp_int& n);
+
+  // Les `count` premiers >= start, dans l'ordre.
+  std::vector<cpp_int> generate_primes(const cpp_int& start, std::size_t count);
+  void generate_primes(const cpp_int& start, std::size_t count, const std::function<void(const cpp_int&)>& emit);
+  // Même chose vers sink (chemin des exécutables) ; renvoie le nombre émis.
+  std::size_t generate_primes(const cpp_int& start, std::size_t count, PrimeSink& sink);
+
+  // Premiers >= start tenant sur 64 bits : peut en renvoyer moins que `count`.
+  std::vector<std::uint64_t> generate_primes_u64(std::uint64_t start, std::size_t count);
+
+  // Les `count` premiers <= start, décroissants ; moins s'ils s'arrêtent à 2.
+  std::vector<cpp_int> generate_primes_down(const cpp_int& start, std::size_t count);
+  void generate_primes_down(const cpp_int& start, std::size_t count, const std::function<void(const cpp_int&)>& emit);
+  std::vector<std::uint64_t> generate_primes_u64_down(std::uint64_t start, std::size_t count);
+  std::size_t generate_primes_down(const cpp_int& start, std::size_t count, PrimeSink& sink);
+
+  // out[i] = is_prime(n[i]), par lots répartis sur le pool (PrimeBatch.h)
+  void is_prime_batch(const std::uint64_t* n, std::size_t len, bool* out);
+  void is_prime_batch(const cpp_int* n, std::size_t len, bool* out);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace primes
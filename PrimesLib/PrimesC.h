@@ -0,0 +1,82 @@
+/* PrimesC.h
+ * Interface C de la bibliothèque PrimesLib. Les grands entiers sont passés en mots de
+ * 64 bits, poids faible d'abord (comme --format limbs), sans conversion en texte.
+ * Aucune exception ne traverse l'interface : -1 (ou 0 pour une taille, sauf
+ * primes_generate) signale une erreur (contexte nul, mémoire insuffisante).
+ *
+ * Bibliothèque partagée : définir PRIMES_SHARED chez l'appelant (dllimport sous Windows) ;
+ * PRIMES_BUILD est défini par le projet qui la compile. */
+
+#ifndef PRIMES_C_H
+#define PRIMES_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(PRIMES_SHARED) && defined(_WIN32)
+#ifdef PRIMES_BUILD
+#define PRIMES_API __declspec(dllexport)
+#else
+#define PRIMES_API __declspec(dllimport)
+#endif
+#elif defined(PRIMES_SHARED) && defined(__GNUC__)
+#define PRIMES_API __attribute__((visibility("default")))
+#else
+#define PRIMES_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct primes_context primes_context;
+
+/* Rappel de primes_generate : un premier de `len` mots. Renvoie 0 pour arrêter. */
+typedef int (*primes_emit)(void* user, const uint64_t* limbs, size_t len);
+
+/* threads : 1 séquentiel, 0 un par cœur ; seed = 0 : graine aléatoire. NULL en cas d'échec. */
+PRIMES_API primes_context* primes_create(unsigned threads, uint64_t seed);
+PRIMES_API void primes_destroy(primes_context* ctx);
+
+/* 1 premier, 0 composé, -1 erreur */
+PRIMES_API int primes_is_prime_u64(primes_context* ctx, uint64_t n);
+PRIMES_API int primes_is_prime(primes_context* ctx, const uint64_t* limbs, size_t len);
+
+/* Plus petit premier > n ; 0 s'il dépasse 2^64 - 1. */
+PRIMES_API uint64_t primes_next_prime_u64(primes_context* ctx, uint64_t n);
+
+/* Plus grand premier < n ; 0 si n <= 2. */
+PRIMES_API uint64_t primes_prev_prime_u64(primes_context* ctx, uint64_t n);
+
+/* Plus petit premier > n, écrit dans out s'il tient dans `capacity` mots ; renvoie son
+ * nombre de mots (à rappeler avec un tampon plus grand s'il dépasse capacity), 0 si erreur. */
+PRIMES_API size_t primes_next_prime(primes_context* ctx, const uint64_t* limbs, size_t len, uint64_t* out,
+                                    size_t capacity);
+
+/* Les premiers >= start tenant sur 64 bits, au plus `count`, dans out ; renvoie leur nombre. */
+PRIMES_API size_t primes_generate_u64(primes_context* ctx, uint64_t start, size_t count, uint64_t* out);
+
+/* Les premiers <= start, décroissants, au plus `count`, dans out ; renvoie leur nombre
+ * (inférieur à count si la suite s'arrête à 2). */
+PRIMES_API size_t primes_generate_down_u64(primes_context* ctx, uint64_t start, size_t count, uint64_t* out);
+
+/* Valeur de retour de primes_generate en cas d'erreur (0 y est un résultat possible). */
+#define PRIMES_GENERATE_ERROR ((size_t)-1)
+
+/* Les `count` premiers >= start passés dans l'ordre à emit ; renvoie le nombre émis
+ * (arrêt par emit compris), ou PRIMES_GENERATE_ERROR en cas d'erreur : arguments
+ * invalides, mémoire insuffisante, les premiers déjà émis restant valables. */
+PRIMES_API size_t primes_generate(primes_context* ctx, const uint64_t* limbs, size_t len, size_t count,
+                                  primes_emit emit, void* user);
+
+/* out[i] = 1 si n[i] est premier, 0 sinon ; renvoie 0, ou -1 en cas d'erreur (dont
+ * limbs[i] nul avec lens[i] != 0 ; out n'est alors pas rempli). */
+PRIMES_API int primes_is_prime_batch_u64(primes_context* ctx, const uint64_t* n, size_t count, unsigned char* out);
+PRIMES_API int primes_is_prime_batch(primes_context* ctx, const uint64_t* const* limbs, const size_t* lens,
+                                     size_t count, unsigned char* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PRIMES_C_H */